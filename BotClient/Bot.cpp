@@ -0,0 +1,268 @@
+#include "Bot.hpp"
+
+#include <cmath>
+
+#include <SFML/Network/Packet.hpp>
+
+#include "MessageWriter.hpp"
+#include "NetworkProtocol.hpp"
+#include "PlayerAction.hpp"
+
+namespace
+{
+	const sf::Time kConnectTimeout = sf::seconds(5.f);
+	const sf::Time kAckInterval = sf::seconds(1.f / 20.f);
+	//Matches PredictedBike, so a bot sends the same amount of input a real client does
+	const std::size_t kMaxInputsPerPacket = 16;
+	//Every bot weaves up and down the track on its own phase, and boosts now and then
+	const float kWeavePeriod = 3.f;
+	const float kBoostPeriod = 7.f;
+}
+
+Bot::ScriptedBike::ScriptedBike()
+	: m_unacknowledged()
+	, m_next_sequence(1)
+	, m_held(0)
+{
+}
+
+Bot::Bot(std::size_t index, const sf::IpAddress& address, unsigned short port, bool request_partner)
+	: m_connection(nullptr)
+	, m_index(index)
+	, m_request_partner(request_partner)
+	, m_joined(false)
+	, m_failed(false)
+	, m_last_snapshot(0)
+	, m_server_tick(0)
+	, m_snapshots_received(0)
+	, m_elapsed(sf::Time::Zero)
+	, m_since_ack(sf::Time::Zero)
+{
+	m_connection = m_host.Connect(address, port);
+	m_failed = m_connection == nullptr;
+}
+
+void Bot::Update(sf::Time dt)
+{
+	if (m_failed)
+	{
+		return;
+	}
+
+	m_elapsed += dt;
+	m_host.Receive();
+
+	if (m_connection->GetState() == UdpConnection::State::kConnecting)
+	{
+		m_failed = m_elapsed > kConnectTimeout;
+		m_host.Update();
+		return;
+	}
+	if (!m_connection->IsConnected())
+	{
+		m_failed = true;
+		return;
+	}
+
+	if (!m_joined)
+	{
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::JoinMatch>(static_cast<sf::Uint32>(0));
+		m_connection->Send(message, Delivery::kReliableOrdered);
+		m_joined = true;
+	}
+
+	while (m_connection->Receive(m_receive_packet))
+	{
+		HandlePacket(m_receive_packet);
+	}
+
+	for (std::size_t i = 0; i < m_bike_order.size(); ++i)
+	{
+		sf::Int32 identifier = m_bike_order[i];
+		SendInput(identifier, m_bikes[identifier], GetScriptedInput(i));
+	}
+
+	m_since_ack += dt;
+	if (m_since_ack >= kAckInterval)
+	{
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::SnapshotAck>(m_last_snapshot);
+		m_connection->Send(message, Delivery::kUnreliableSequenced);
+		m_since_ack = sf::Time::Zero;
+	}
+
+	m_host.Update();
+}
+
+void Bot::RequestStart()
+{
+	if (IsPlaying())
+	{
+		MessageWriter message(m_message_buffer);
+		m_connection->Send(message.WriteMessage<ClientMessage::ClientStart>(), Delivery::kReliableOrdered);
+	}
+}
+
+void Bot::Quit()
+{
+	if (m_connection && m_connection->IsConnected())
+	{
+		MessageWriter message(m_message_buffer);
+		m_connection->Send(message.WriteMessage<ClientMessage::Quit>(), Delivery::kReliableOrdered);
+		m_connection->Flush();
+	}
+}
+
+bool Bot::IsPlaying() const
+{
+	return !m_failed && !m_bike_order.empty();
+}
+
+bool Bot::HasFailed() const
+{
+	return m_failed;
+}
+
+const UdpHost::TrafficCounters& Bot::GetTraffic() const
+{
+	return m_host.GetTraffic();
+}
+
+sf::Uint32 Bot::GetServerTick() const
+{
+	return m_server_tick;
+}
+
+std::size_t Bot::GetSnapshotsReceived() const
+{
+	return m_snapshots_received;
+}
+
+void Bot::HandlePacket(sf::Packet& packet)
+{
+	sf::Int32 packet_type;
+	packet >> packet_type;
+
+	switch (static_cast<Server::PacketType>(packet_type))
+	{
+	case Server::PacketType::InitialState:
+	{
+		float world_width, battlefield_height;
+		packet >> world_width >> battlefield_height;
+		m_snapshot_codec = SnapshotCodec(sf::Vector2f(world_width, battlefield_height));
+	}
+	break;
+
+	case Server::PacketType::SpawnSelf:
+	case Server::PacketType::AcceptCoopPartner:
+	{
+		sf::Int32 identifier;
+		packet >> identifier;
+		m_bikes[identifier] = ScriptedBike();
+		m_bike_order.push_back(identifier);
+
+		if (m_request_partner && m_bike_order.size() == 1)
+		{
+			MessageWriter message(m_message_buffer);
+			m_connection->Send(message.WriteMessage<ClientMessage::RequestCoopPartner>(), Delivery::kReliableOrdered);
+		}
+	}
+	break;
+
+	case Server::PacketType::UpdateClientState:
+	{
+		WorldSnapshot snapshot;
+		if (!m_snapshot_codec.ReadDelta(packet, m_snapshot_history, snapshot) || snapshot.m_sequence <= m_last_snapshot)
+		{
+			break;
+		}
+		m_snapshot_history.Store(snapshot);
+		m_last_snapshot = snapshot.m_sequence;
+		m_server_tick = snapshot.m_tick;
+		++m_snapshots_received;
+
+		//Stop resending whatever the server has applied
+		for (auto& bike : m_bikes)
+		{
+			const BikeSnapshot* state = snapshot.FindBike(bike.first);
+			if (!state)
+			{
+				continue;
+			}
+			std::deque<InputCommand>& inputs = bike.second.m_unacknowledged;
+			while (!inputs.empty() && inputs.front().m_sequence <= state->m_last_input)
+			{
+				inputs.pop_front();
+			}
+		}
+	}
+	break;
+
+	//Answered like a real client, so the server's statistics cover bots too
+	case Server::PacketType::Ping:
+	{
+		sf::Uint32 timestamp;
+		packet >> timestamp;
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::Pong>(timestamp);
+		m_connection->Send(message, Delivery::kUnreliableSequenced);
+	}
+	break;
+
+	default:
+		break;
+	}
+}
+
+InputBits Bot::GetScriptedInput(std::size_t bike_index) const
+{
+	float time = m_elapsed.asSeconds() + static_cast<float>(m_index * 2 + bike_index) * 0.37f;
+	float weave = std::sin(time * 2.f * 3.14159265f / kWeavePeriod);
+
+	InputBits input = ToInputBit(PlayerAction::kMoveRight);
+	if (weave > 0.3f)
+	{
+		input |= ToInputBit(PlayerAction::kMoveUp);
+	}
+	else if (weave < -0.3f)
+	{
+		input |= ToInputBit(PlayerAction::kMoveDown);
+	}
+	if (std::fmod(time, kBoostPeriod) < 0.1f)
+	{
+		input |= ToInputBit(PlayerAction::kBoost);
+	}
+	return input;
+}
+
+void Bot::SendInput(sf::Int32 identifier, ScriptedBike& bike, InputBits input)
+{
+	//Key changes go out the way Player sends them, so the realtime relay gets its share of the load too
+	for (int action = 0; action < static_cast<int>(PlayerAction::kActionCount); ++action)
+	{
+		InputBits bit = ToInputBit(static_cast<PlayerAction>(action));
+		if ((bike.m_held & bit) != (input & bit))
+		{
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ClientMessage::PlayerRealtimeChange>(identifier, static_cast<sf::Int32>(action), (input & bit) != 0);
+			m_connection->Send(message, Delivery::kReliableOrdered);
+		}
+	}
+	bike.m_held = input;
+
+	bike.m_unacknowledged.push_back(InputCommand{ bike.m_next_sequence++, input });
+	while (bike.m_unacknowledged.size() > kMaxInputsPerPacket)
+	{
+		bike.m_unacknowledged.pop_front();
+	}
+
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ClientMessage::PlayerInput>(identifier, static_cast<sf::Uint8>(bike.m_unacknowledged.size()));
+	for (const InputCommand& command : bike.m_unacknowledged)
+	{
+		message << command.m_sequence << command.m_input;
+	}
+	m_connection->Send(message, Delivery::kUnreliableSequenced);
+}
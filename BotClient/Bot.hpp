@@ -0,0 +1,72 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "BikeSimulation.hpp"
+#include "Snapshot.hpp"
+#include "UdpHost.hpp"
+
+//One simulated player. It connects and joins a match the way MultiplayerGameState does, drives its bikes with a
+//scripted weave instead of the keyboard, and acknowledges snapshots so the server deltas against them as usual.
+//Each bot has its own socket, so the server sees it as a separate peer
+class Bot : private sf::NonCopyable
+{
+public:
+	Bot(std::size_t index, const sf::IpAddress& address, unsigned short port, bool request_partner);
+
+	void Update(sf::Time dt);
+	void RequestStart();
+	void Quit();
+
+	bool IsPlaying() const;
+	bool HasFailed() const;
+	const UdpHost::TrafficCounters& GetTraffic() const;
+	sf::Uint32 GetServerTick() const;
+	std::size_t GetSnapshotsReceived() const;
+
+private:
+	//Inputs are resent until a snapshot shows the server has applied them, like PredictedBike does
+	struct ScriptedBike
+	{
+		ScriptedBike();
+		std::deque<InputCommand> m_unacknowledged;
+		sf::Uint32 m_next_sequence;
+		InputBits m_held;
+	};
+
+private:
+	void HandlePacket(sf::Packet& packet);
+	InputBits GetScriptedInput(std::size_t bike_index) const;
+	void SendInput(sf::Int32 identifier, ScriptedBike& bike, InputBits input);
+
+private:
+	UdpHost m_host;
+	UdpConnection* m_connection;
+	std::size_t m_index;
+	bool m_request_partner;
+	bool m_joined;
+	bool m_failed;
+
+	std::map<sf::Int32, ScriptedBike> m_bikes;
+	std::vector<sf::Int32> m_bike_order;
+
+	SnapshotCodec m_snapshot_codec;
+	SnapshotHistory m_snapshot_history;
+	sf::Uint32 m_last_snapshot;
+	sf::Uint32 m_server_tick;
+	std::size_t m_snapshots_received;
+
+	sf::Time m_elapsed;
+	sf::Time m_since_ack;
+
+	//Reused for every message, like the real client
+	std::vector<char> m_message_buffer;
+	sf::Packet m_receive_packet;
+};
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include "Bot.hpp"
+#include "CommandLine.hpp"
+#include "NetworkProtocol.hpp"
+
+//Headless load generator: connects many scripted players to a server and reports what the server keeps up with
+//Usage: MotorRushBots [--address 127.0.0.1] [--port 50000] [--bots 15] [--partners 0] [--ramp 50] [--start-after 3] [--duration 0] [--report-interval 1]
+
+namespace
+{
+	//Each bot has a socket of its own, so this is already more than one process can open on most systems
+	const unsigned long kMaxBots = 10000;
+
+	volatile std::sig_atomic_t ShutdownRequested = 0;
+
+	void HandleShutdownSignal(int)
+	{
+		ShutdownRequested = 1;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: MotorRushBots [--address <server address>] [--port <port>] [--bots <count>] [--partners <bots that also request a coop partner>]"
+			<< " [--ramp <bots connected per second>] [--start-after <seconds, 0 to never start>] [--duration <seconds, 0 to run until stopped>]"
+			<< " [--report-interval <seconds>]" << std::endl;
+	}
+
+	//Per-bot rates over one report interval
+	struct Rates
+	{
+		Rates() : m_min(0.f), m_max(0.f), m_total(0.f), m_count(0) {}
+
+		void Add(float value)
+		{
+			m_min = m_count == 0 ? value : std::min(m_min, value);
+			m_max = m_count == 0 ? value : std::max(m_max, value);
+			m_total += value;
+			++m_count;
+		}
+
+		float Average() const
+		{
+			return m_count == 0 ? 0.f : m_total / m_count;
+		}
+
+		float m_min;
+		float m_max;
+		float m_total;
+		std::size_t m_count;
+	};
+
+	std::ostream& operator<<(std::ostream& out, const Rates& rates)
+	{
+		return out << rates.Average() << " (" << rates.m_min << "-" << rates.m_max << ")";
+	}
+
+	//What a bot had counted at the previous report
+	struct BotTotals
+	{
+		UdpHost::TrafficCounters m_traffic;
+		std::size_t m_snapshots;
+		sf::Uint32 m_server_tick;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	std::string address = "127.0.0.1";
+	unsigned short port = SERVER_PORT;
+	std::size_t bot_count = 15;
+	std::size_t partner_count = 0;
+	float ramp = 50.f;
+	float start_after = 3.f;
+	float duration = 0.f;
+	float report_interval = 1.f;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		if (i + 1 >= argc)
+		{
+			std::cout << "Missing value for " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+
+		std::string value = argv[++i];
+		bool valid = true;
+		unsigned long number = 0;
+		if (argument == "--address")
+		{
+			address = value;
+		}
+		else if (argument == "--port")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, 65535, number);
+			port = static_cast<unsigned short>(number);
+		}
+		else if (argument == "--bots")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, kMaxBots, number);
+			bot_count = static_cast<std::size_t>(number);
+		}
+		else if (argument == "--partners")
+		{
+			valid = CommandLine::ParseUnsigned(value, 0, kMaxBots, number);
+			partner_count = static_cast<std::size_t>(number);
+		}
+		else if (argument == "--ramp")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), ramp) && ramp > 0.f;
+		}
+		else if (argument == "--start-after")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), start_after);
+		}
+		else if (argument == "--duration")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), duration);
+		}
+		else if (argument == "--report-interval")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), report_interval) && report_interval > 0.f;
+		}
+		else
+		{
+			std::cout << "Unknown argument " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+
+		if (!valid)
+		{
+			std::cout << "Invalid value " << value << " for " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	sf::IpAddress server_address(address);
+	if (server_address == sf::IpAddress::None)
+	{
+		std::cout << "Could not resolve server address " << address << std::endl;
+		PrintUsage();
+		return 1;
+	}
+
+	std::signal(SIGINT, HandleShutdownSignal);
+	std::signal(SIGTERM, HandleShutdownSignal);
+
+	//Bots run at the client frame rate, each sends input every frame like a real client
+	const sf::Time frame_time = kSimulationStep;
+	std::vector<std::unique_ptr<Bot>> bots;
+	std::vector<BotTotals> totals;
+	bool started = false;
+
+	sf::Clock clock;
+	sf::Time next_frame = sf::Time::Zero;
+	sf::Time next_report = sf::seconds(report_interval);
+	std::cout << std::fixed << std::setprecision(1);
+
+	while (!ShutdownRequested && (duration <= 0.f || clock.getElapsedTime() < sf::seconds(duration)))
+	{
+		sf::Time now = clock.getElapsedTime();
+
+		//Connect gradually so the server is not hit by every handshake at once
+		std::size_t wanted = std::min(bot_count, static_cast<std::size_t>(now.asSeconds() * ramp) + 1);
+		while (bots.size() < wanted)
+		{
+			bool request_partner = bots.size() < partner_count;
+			bots.emplace_back(new Bot(bots.size(), server_address, port, request_partner));
+			totals.push_back(BotTotals{ UdpHost::TrafficCounters(), 0, 0 });
+		}
+
+		for (auto& bot : bots)
+		{
+			bot->Update(frame_time);
+		}
+
+		//The first bot plays the host and starts the race once everyone had time to join
+		if (!started && start_after > 0.f && bots.size() == bot_count && now > sf::seconds(bot_count / ramp + start_after))
+		{
+			bots.front()->RequestStart();
+			started = true;
+		}
+
+		if (now >= next_report)
+		{
+			Rates packets_in, bytes_in, packets_out, bytes_out, snapshots, server_ticks;
+			std::size_t playing = 0;
+			std::size_t failed = 0;
+			for (std::size_t i = 0; i < bots.size(); ++i)
+			{
+				const Bot& bot = *bots[i];
+				const UdpHost::TrafficCounters& traffic = bot.GetTraffic();
+				BotTotals& previous = totals[i];
+
+				if (bot.HasFailed())
+				{
+					++failed;
+				}
+				else if (bot.IsPlaying())
+				{
+					++playing;
+					packets_in.Add((traffic.m_datagrams_received - previous.m_traffic.m_datagrams_received) / report_interval);
+					bytes_in.Add((traffic.m_bytes_received - previous.m_traffic.m_bytes_received) / report_interval);
+					packets_out.Add((traffic.m_datagrams_sent - previous.m_traffic.m_datagrams_sent) / report_interval);
+					bytes_out.Add((traffic.m_bytes_sent - previous.m_traffic.m_bytes_sent) / report_interval);
+					snapshots.Add((bot.GetSnapshotsReceived() - previous.m_snapshots) / report_interval);
+					//The server steps at a fixed rate, fewer ticks per second than that means it is falling behind
+					if (previous.m_server_tick != 0)
+					{
+						server_ticks.Add((bot.GetServerTick() - previous.m_server_tick) / report_interval);
+					}
+				}
+
+				previous = BotTotals{ traffic, bot.GetSnapshotsReceived(), bot.GetServerTick() };
+			}
+
+			std::cout << "[" << now.asSeconds() << "s] bots " << playing << "/" << bots.size() << " playing, " << failed << " failed"
+				<< " | server ticks/s " << server_ticks << " of " << 1.f / kSimulationStep.asSeconds()
+				<< " | per bot: snapshots/s " << snapshots
+				<< ", in " << packets_in << " pkt/s " << bytes_in << " B/s"
+				<< ", out " << packets_out << " pkt/s " << bytes_out << " B/s" << std::endl;
+
+			next_report += sf::seconds(report_interval);
+		}
+
+		next_frame += frame_time;
+		sf::Time remaining = next_frame - clock.getElapsedTime();
+		if (remaining > sf::Time::Zero)
+		{
+			sf::sleep(remaining);
+		}
+	}
+
+	std::cout << "Disconnecting bots" << std::endl;
+	for (auto& bot : bots)
+	{
+		bot->Quit();
+	}
+}
@@ -0,0 +1,196 @@
+#include "MatchReplay.hpp"
+
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include <SFML/System/Clock.hpp>
+
+#include "Connection.hpp"
+#include "GameServer.hpp"
+#include "MatchRecording.hpp"
+#include "UdpHost.hpp"
+
+namespace
+{
+	const sf::Uint32 kChecksumOffset = 2166136261u;
+	const sf::Uint32 kChecksumPrime = 16777619u;
+
+	//Hands the server the packets a peer sent in the recording and swallows everything sent back
+	class ReplayConnection : public Connection
+	{
+	public:
+		explicit ReplayConnection(MatchReplay::Result& result)
+			: m_result(result)
+			, m_dropped(false)
+		{
+		}
+
+		using Connection::Send;
+		void Send(const MessagePayload& payload, Delivery delivery) override
+		{
+			Send(payload->data(), payload->size(), delivery);
+		}
+
+		void Send(const char* data, std::size_t size, Delivery delivery) override
+		{
+			m_result.m_messages_sent++;
+			m_result.m_bytes_sent += size;
+			m_traffic.m_bytes_sent += size;
+			//The channel is part of the output, a message moved to the other one changes the checksum
+			m_result.m_checksum = (m_result.m_checksum ^ static_cast<sf::Uint8>(delivery)) * kChecksumPrime;
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				m_result.m_checksum = (m_result.m_checksum ^ static_cast<sf::Uint8>(data[i])) * kChecksumPrime;
+			}
+		}
+
+		void Flush() override
+		{
+		}
+
+		bool Receive(sf::Packet& packet) override
+		{
+			if (m_received.empty())
+			{
+				return false;
+			}
+			packet.clear();
+			packet.append(m_received.front().data(), m_received.front().size());
+			m_traffic.m_bytes_received += m_received.front().size();
+			m_received.pop();
+			m_result.m_packets++;
+			return true;
+		}
+
+		bool IsConnected() const override
+		{
+			return !m_dropped;
+		}
+
+		//Timeouts were recorded as drops, so replayed peers never go quiet on their own
+		sf::Time GetTimeSinceLastReceive() const override
+		{
+			return sf::Time::Zero;
+		}
+
+		const ConnectionTraffic& GetTraffic() const override
+		{
+			return m_traffic;
+		}
+
+		void Queue(std::vector<char>& data)
+		{
+			m_received.emplace(std::move(data));
+		}
+
+		void Drop()
+		{
+			m_dropped = true;
+		}
+
+	private:
+		MatchReplay::Result& m_result;
+		std::queue<std::vector<char>> m_received;
+		ConnectionTraffic m_traffic;
+		bool m_dropped;
+	};
+}
+
+MatchReplay::Result::Result()
+	: m_match_time(sf::Time::Zero)
+	, m_wall_time(sf::Time::Zero)
+	, m_peers(0)
+	, m_advances(0)
+	, m_packets(0)
+	, m_messages_sent(0)
+	, m_bytes_sent(0)
+	, m_checksum(kChecksumOffset)
+{
+}
+
+MatchReplay::MatchReplay(const std::string& path)
+	: m_path(path)
+{
+}
+
+bool MatchReplay::Run(Result& result)
+{
+	MatchRecordingReader reader;
+	MatchRecordingHeader header;
+	if (!reader.Open(m_path, header))
+	{
+		return false;
+	}
+
+	ServerSettings settings;
+	settings.m_max_connected_players = header.m_max_connected_players;
+	settings.m_tick_rate = header.m_tick_rate;
+	settings.m_interest_radius = header.m_interest_radius;
+	settings.m_random_seed = header.m_random_seed;
+	settings.m_track_difficulty = header.m_track_difficulty;
+	settings.m_peer_bandwidth = header.m_peer_bandwidth;
+
+	//The match needs a host to exist but never touches it, the host's socket is never bound.
+	//Peers are declared first so they outlive the server
+	std::vector<std::unique_ptr<ReplayConnection>> peers;
+	UdpHost host;
+	GameServer server(header.m_battlefield_size, settings, host);
+
+	result = Result();
+	sf::Clock clock;
+	MatchEvent event;
+	bool has_event = reader.ReadEvent(event);
+	while (has_event)
+	{
+		switch (event.m_type)
+		{
+		case MatchEvent::Type::kPeerConnected:
+		{
+			if (event.m_peer >= peers.size())
+			{
+				peers.resize(event.m_peer + 1);
+			}
+			peers[event.m_peer].reset(new ReplayConnection(result));
+			server.AddPeer(peers[event.m_peer].get());
+			result.m_peers++;
+			has_event = reader.ReadEvent(event);
+		}
+		break;
+
+		case MatchEvent::Type::kAdvance:
+		{
+			//What the Advance handled was recorded after it, so queue that up before running it
+			sf::Time elapsed = event.m_elapsed;
+			while ((has_event = reader.ReadEvent(event)) && (event.m_type == MatchEvent::Type::kPacket || event.m_type == MatchEvent::Type::kPeerDropped))
+			{
+				if (event.m_peer >= peers.size() || !peers[event.m_peer])
+				{
+					continue;
+				}
+				if (event.m_type == MatchEvent::Type::kPacket)
+				{
+					peers[event.m_peer]->Queue(event.m_data);
+				}
+				else
+				{
+					peers[event.m_peer]->Drop();
+				}
+			}
+
+			server.Advance(elapsed);
+			server.CloseDroppedConnections();
+			result.m_match_time += elapsed;
+			result.m_advances++;
+		}
+		break;
+
+		default:
+			//Packets and drops only ever follow an Advance
+			has_event = reader.ReadEvent(event);
+			break;
+		}
+	}
+	result.m_wall_time = clock.getElapsedTime();
+	return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+//Runs a match recorded by GameServer again as fast as it can, without sockets or a clock. The server makes the
+//same decisions from the same recording, so a replay reproduces what went wrong in a match, and timing one is a
+//repeatable benchmark of Tick and HandleIncomingPacket
+class MatchReplay : private sf::NonCopyable
+{
+public:
+	struct Result
+	{
+		Result();
+		sf::Time m_match_time;
+		sf::Time m_wall_time;
+		std::size_t m_peers;
+		std::size_t m_advances;
+		std::size_t m_packets;
+		std::size_t m_messages_sent;
+		std::size_t m_bytes_sent;
+		//Of everything the server sent, in order. Replays of the same recording must agree on it
+		sf::Uint32 m_checksum;
+	};
+
+public:
+	explicit MatchReplay(const std::string& path);
+	//False if the recording could not be opened
+	bool Run(Result& result);
+
+private:
+	std::string m_path;
+};
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <SFML/System/Sleep.hpp>
+
+#include "CommandLine.hpp"
+#include "MatchReplay.hpp"
+#include "NetworkProtocol.hpp"
+#include "SessionManager.hpp"
+
+//Headless entry point for running many GameServer matches as a dedicated server
+//Usage: MotorRushServer [--port 50000] [--max-players 15] [--tick-rate 15] [--loss 0.1] [--interest-radius 2000] [--bandwidth 32000] [--matches 8] [--workers 2]
+//	[--seed 1234] [--difficulty 1] [--record capture] [--stats network]
+//Or, to run a recorded match again offline: MotorRushServer --replay capture-1.rec [--runs 10]
+
+namespace
+{
+	//Limits on what the arguments accept, well beyond anything one box runs
+	const unsigned long kMaxCount = 100000;
+	const unsigned long kMaxWorkers = 256;
+	const float kMinTickRate = 0.1f;
+	const float kMaxTickRate = 1000.f;
+
+	volatile std::sig_atomic_t ShutdownRequested = 0;
+
+	void HandleShutdownSignal(int)
+	{
+		ShutdownRequested = 1;
+	}
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: MotorRushServer [--port <port>] [--max-players <count>] [--tick-rate <ticks per second>] [--loss <fraction of datagrams to drop>] [--interest-radius <distance along the track>] [--bandwidth <snapshot bytes per second per peer, 0 for no limit>] [--matches <count>] [--workers <threads>] [--seed <random seed>] [--difficulty <obstacle density>] [--record <file prefix>] [--stats <file prefix>]" << std::endl;
+		std::cout << "       MotorRushServer --replay <recording> [--runs <count>]" << std::endl;
+		std::cout << "--max-players, --tick-rate, --interest-radius, --bandwidth and --difficulty apply to each match, --record writes <file prefix>-<match>.rec for each match" << std::endl;
+		std::cout << "--stats writes every peer's round trip, jitter, loss and bandwidth to <file prefix>-<match>.csv once a second" << std::endl;
+	}
+
+	int RunReplay(const std::string& path, int runs)
+	{
+		MatchReplay replay(path);
+		for (int run = 1; run <= runs; ++run)
+		{
+			MatchReplay::Result result;
+			if (!replay.Run(result))
+			{
+				std::cout << "Could not read recording " << path << std::endl;
+				return 1;
+			}
+
+			float wall_seconds = std::max(result.m_wall_time.asSeconds(), 0.000001f);
+			std::cout << "Run " << run << ": replayed " << result.m_match_time.asSeconds() << "s of match in " << result.m_wall_time.asMilliseconds() << "ms ("
+				<< result.m_match_time.asSeconds() / wall_seconds << "x real time), " << result.m_peers << " peers, " << result.m_advances << " advances, "
+				<< result.m_packets << " packets handled (" << static_cast<std::size_t>(result.m_packets / wall_seconds) << "/s), "
+				<< result.m_messages_sent << " messages and " << result.m_bytes_sent << " bytes sent, checksum " << std::hex << result.m_checksum << std::dec << std::endl;
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	SessionSettings session_settings;
+	ServerSettings& settings = session_settings.m_match;
+	float tick_rate = 15.f;
+	std::string replay_path;
+	int replay_runs = 1;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h")
+		{
+			PrintUsage();
+			return 0;
+		}
+		if (i + 1 >= argc)
+		{
+			std::cout << "Missing value for " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+
+		std::string value = argv[++i];
+		bool valid = true;
+		unsigned long number = 0;
+		if (argument == "--port")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, 65535, number);
+			settings.m_port = static_cast<unsigned short>(number);
+		}
+		else if (argument == "--max-players")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, kMaxCount, number);
+			settings.m_max_connected_players = static_cast<std::size_t>(number);
+		}
+		else if (argument == "--tick-rate")
+		{
+			valid = CommandLine::ParseFloat(value, kMinTickRate, kMaxTickRate, tick_rate);
+		}
+		else if (argument == "--bandwidth")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), settings.m_peer_bandwidth);
+		}
+		else if (argument == "--interest-radius")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), settings.m_interest_radius) && settings.m_interest_radius > 0.f;
+		}
+		else if (argument == "--matches")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, kMaxCount, number);
+			session_settings.m_max_matches = static_cast<std::size_t>(number);
+		}
+		else if (argument == "--workers")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, kMaxWorkers, number);
+			session_settings.m_worker_count = static_cast<std::size_t>(number);
+		}
+		else if (argument == "--seed")
+		{
+			valid = CommandLine::ParseUnsigned(value, 0, std::numeric_limits<sf::Uint32>::max(), number);
+			settings.m_random_seed = static_cast<sf::Uint32>(number);
+		}
+		else if (argument == "--difficulty")
+		{
+			valid = CommandLine::ParseFloat(value, 0.f, std::numeric_limits<float>::max(), settings.m_track_difficulty);
+		}
+		else if (argument == "--record")
+		{
+			settings.m_record_path = value;
+		}
+		else if (argument == "--stats")
+		{
+			settings.m_statistics_path = value;
+		}
+		else if (argument == "--replay")
+		{
+			replay_path = value;
+		}
+		else if (argument == "--runs")
+		{
+			valid = CommandLine::ParseUnsigned(value, 1, kMaxCount, number);
+			replay_runs = static_cast<int>(number);
+		}
+		else if (argument == "--loss")
+		{
+			//Simulated packet loss, for testing how the game copes with a bad network
+			valid = CommandLine::ParseFloat(value, 0.f, 1.f, settings.m_simulated_loss) && settings.m_simulated_loss < 1.f;
+		}
+		else
+		{
+			std::cout << "Unknown argument " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+
+		if (!valid)
+		{
+			std::cout << "Invalid value " << value << " for " << argument << std::endl;
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	settings.m_tick_rate = sf::seconds(1.f / tick_rate);
+
+	//A replay takes everything it needs from the recording and never opens a socket
+	if (!replay_path.empty())
+	{
+		return RunReplay(replay_path, std::max(replay_runs, 1));
+	}
+
+	std::signal(SIGINT, HandleShutdownSignal);
+	std::signal(SIGTERM, HandleShutdownSignal);
+
+	try
+	{
+		//The server runs its loop on its own thread, the main thread only waits for a shutdown signal
+		SessionManager server(sf::Vector2f(1024.f, 768.f), session_settings);
+		std::cout << "Server started on port " << settings.m_port << " for up to " << session_settings.m_max_matches << " matches of "
+			<< settings.m_max_connected_players << " players at " << tick_rate << " ticks per second on " << session_settings.m_worker_count << " workers" << std::endl;
+
+		while (!ShutdownRequested)
+		{
+			sf::sleep(sf::milliseconds(100));
+		}
+
+		std::cout << "Shutting down server" << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "\nEXCEPTION: " << e.what() << std::endl;
+		return 1;
+	}
+}
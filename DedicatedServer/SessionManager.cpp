@@ -0,0 +1,231 @@
+#include "SessionManager.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <SFML/Network/Packet.hpp>
+
+#include "MessageWriter.hpp"
+#include "NetworkProtocol.hpp"
+
+namespace
+{
+	//A connection that has not asked for a match by then is dropped
+	const sf::Time kJoinTimeout = sf::seconds(5.f);
+	//Longest the loop sleeps with no match to tick
+	const sf::Time kIdleWait = sf::milliseconds(100);
+}
+
+SessionSettings::SessionSettings()
+	: m_match()
+	, m_max_matches(8)
+	, m_worker_count(2)
+{
+}
+
+SessionManager::SessionManager(sf::Vector2f battlefield_size, const SessionSettings& settings)
+	: m_thread(&SessionManager::ExecutionThread, this)
+	, m_workers(settings.m_worker_count)
+	, m_waiting_thread_end(false)
+	, m_battlefield_size(battlefield_size)
+	, m_settings(settings)
+	, m_match_identifier_counter(1)
+	, m_seed(settings.m_match.m_random_seed != 0 ? settings.m_match.m_random_seed : RandomStream::SeedFromClock())
+	, m_max_pending_connections(std::max<std::size_t>(settings.m_max_matches * settings.m_match.m_max_connected_players, 1))
+{
+	m_host.SetSimulatedLoss(settings.m_match.m_simulated_loss);
+	m_thread.launch();
+}
+
+SessionManager::~SessionManager()
+{
+	m_waiting_thread_end.store(true);
+	m_thread.wait();
+}
+
+void SessionManager::ExecutionThread()
+{
+	if (m_host.Listen(m_settings.m_match.m_port))
+	{
+		m_selector.add(m_host.GetSocket());
+	}
+	else
+	{
+		std::cout << "Server could not bind port " << m_settings.m_match.m_port << std::endl;
+	}
+	m_host.SetAcceptingConnections(true);
+
+	while (!m_waiting_thread_end.load())
+	{
+		//SocketSelector treats a zero timeout as infinite, so wait at least 1ms
+		if (m_selector.wait(std::max(GetTimeToNextTick(), sf::milliseconds(1))))
+		{
+			m_host.Receive();
+		}
+
+		AcceptConnections();
+		RoutePendingConnections();
+		AdvanceMatches();
+
+		//Back on this thread only: flush every match's queued messages and handle resends and keep alives
+		m_host.Update();
+	}
+}
+
+void SessionManager::AcceptConnections()
+{
+	UdpConnection* connection;
+	while ((connection = m_host.Accept()) != nullptr)
+	{
+		//Ones the host accepted in the same Receive as the connection that filled the list
+		if (m_pending_connections.size() >= m_max_pending_connections)
+		{
+			m_host.Disconnect(connection);
+			continue;
+		}
+		m_pending_connections.push_back(PendingConnection{ connection, m_host.Now() });
+	}
+	m_host.SetAcceptingConnections(m_pending_connections.size() < m_max_pending_connections);
+}
+
+void SessionManager::RoutePendingConnections()
+{
+	for (auto itr = m_pending_connections.begin(); itr != m_pending_connections.end();)
+	{
+		UdpConnection* connection = itr->m_connection;
+
+		//Anything before the JoinMatch request has nowhere to go yet and is dropped
+		bool requested = false;
+		sf::Uint32 requested_identifier = 0;
+		sf::Packet packet;
+		while (!requested && connection->Receive(packet))
+		{
+			sf::Int32 packet_type;
+			packet >> packet_type;
+			if (static_cast<Client::PacketType>(packet_type) == Client::PacketType::JoinMatch)
+			{
+				packet >> requested_identifier;
+				requested = true;
+			}
+		}
+
+		if (!requested)
+		{
+			if (!connection->IsConnected() || m_host.Now() > itr->m_connected_time + kJoinTimeout)
+			{
+				m_host.Disconnect(connection);
+				itr = m_pending_connections.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+			continue;
+		}
+
+		sf::Uint32 identifier;
+		GameServer* match = FindMatch(requested_identifier, identifier);
+		if (match)
+		{
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ServerMessage::MatchJoined>(identifier);
+			connection->Send(message, Delivery::kReliableOrdered);
+
+			match->AddPeer(connection);
+		}
+		else
+		{
+			std::cout << "Every match is full, turning a player away" << std::endl;
+			m_host.Disconnect(connection);
+		}
+		itr = m_pending_connections.erase(itr);
+	}
+	m_host.SetAcceptingConnections(m_pending_connections.size() < m_max_pending_connections);
+}
+
+//The requested match if it has room, otherwise any match with room, otherwise a new one while there are slots left
+GameServer* SessionManager::FindMatch(sf::Uint32 requested_identifier, sf::Uint32& identifier)
+{
+	auto requested = m_matches.find(requested_identifier);
+	if (requested != m_matches.end() && requested->second->IsAcceptingPlayers())
+	{
+		identifier = requested->first;
+		return requested->second.get();
+	}
+
+	for (auto& match : m_matches)
+	{
+		if (match.second->IsAcceptingPlayers())
+		{
+			identifier = match.first;
+			return match.second.get();
+		}
+	}
+
+	if (m_matches.size() >= m_settings.m_max_matches)
+	{
+		return nullptr;
+	}
+
+	identifier = m_match_identifier_counter++;
+
+	//Every match records and writes statistics to its own files and plays out from its own seed, which is printed so it can be rerun
+	ServerSettings match_settings = m_settings.m_match;
+	match_settings.m_random_seed = static_cast<sf::Uint32>(RandomStream::DeriveSeed(m_seed, identifier));
+	if (match_settings.m_random_seed == 0)
+	{
+		match_settings.m_random_seed = 1;
+	}
+	if (!match_settings.m_record_path.empty())
+	{
+		match_settings.m_record_path += "-" + std::to_string(identifier) + ".rec";
+	}
+	if (!match_settings.m_statistics_path.empty())
+	{
+		match_settings.m_statistics_path += "-" + std::to_string(identifier) + ".csv";
+	}
+
+	MatchPtr& match = m_matches[identifier];
+	match.reset(new GameServer(m_battlefield_size, match_settings, m_host));
+	std::cout << "Started match " << identifier << " with seed " << match_settings.m_random_seed << ", " << m_matches.size() << " running" << std::endl;
+	return match.get();
+}
+
+void SessionManager::AdvanceMatches()
+{
+	//Matches share nothing but the host, and during Advance they only queue on and read from their own
+	//connections, so they can all run at once
+	std::vector<WorkerPool::Job> jobs;
+	jobs.reserve(m_matches.size());
+	for (auto& match : m_matches)
+	{
+		GameServer* server = match.second.get();
+		jobs.emplace_back([server]() { server->Advance(); });
+	}
+	m_workers.Run(jobs);
+
+	for (auto itr = m_matches.begin(); itr != m_matches.end();)
+	{
+		itr->second->CloseDroppedConnections();
+		if (itr->second->IsEmpty())
+		{
+			std::cout << "Match " << itr->first << " ended" << std::endl;
+			itr = m_matches.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+sf::Time SessionManager::GetTimeToNextTick() const
+{
+	sf::Time wait = kIdleWait;
+	for (const auto& match : m_matches)
+	{
+		wait = std::min(wait, match.second->GetTimeToNextTick());
+	}
+	return wait;
+}
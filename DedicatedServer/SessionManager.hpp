@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/SocketSelector.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "GameServer.hpp"
+#include "RandomStream.hpp"
+#include "UdpHost.hpp"
+#include "WorkerPool.hpp"
+
+struct SessionSettings
+{
+	SessionSettings();
+	//The port and packet loss apply to the shared socket, everything else to each match
+	ServerSettings m_match;
+	std::size_t m_max_matches;
+	std::size_t m_worker_count;
+};
+
+//Runs many independent matches in one process on one port. New connections say which match they want with
+//JoinMatch and are handed to it, matches are created as needed and dropped once everyone has left.
+//Only this thread uses the socket; the matches' steps run on the worker pool in between
+class SessionManager : private sf::NonCopyable
+{
+public:
+	SessionManager(sf::Vector2f battlefield_size, const SessionSettings& settings);
+	~SessionManager();
+
+private:
+	struct PendingConnection
+	{
+		UdpConnection* m_connection;
+		sf::Time m_connected_time;
+	};
+
+	typedef std::unique_ptr<GameServer> MatchPtr;
+
+private:
+	void ExecutionThread();
+	void AcceptConnections();
+	void RoutePendingConnections();
+	GameServer* FindMatch(sf::Uint32 requested_identifier, sf::Uint32& identifier);
+	void AdvanceMatches();
+	sf::Time GetTimeToNextTick() const;
+
+private:
+	sf::Thread m_thread;
+	UdpHost m_host;
+	sf::SocketSelector m_selector;
+	WorkerPool m_workers;
+	//Set by the destructor on another thread
+	std::atomic<bool> m_waiting_thread_end;
+
+	sf::Vector2f m_battlefield_size;
+	SessionSettings m_settings;
+	std::map<sf::Uint32, MatchPtr> m_matches;
+	sf::Uint32 m_match_identifier_counter;
+	//Each match's seed is derived from this and the match's identifier
+	sf::Uint32 m_seed;
+	std::vector<PendingConnection> m_pending_connections;
+	//Enough to fill every match at once. Connections are only created for a connect request, which anyone can send,
+	//so the host stops accepting while this many are waiting
+	std::size_t m_max_pending_connections;
+	//Reused for the MatchJoined sent to every routed connection
+	std::vector<char> m_message_buffer;
+};
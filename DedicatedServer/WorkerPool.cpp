@@ -0,0 +1,70 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(std::size_t thread_count)
+	: m_jobs(nullptr)
+	, m_next_job(0)
+	, m_unfinished_jobs(0)
+	, m_stopping(false)
+{
+	for (std::size_t i = 0; i < std::max<std::size_t>(thread_count, 1); ++i)
+	{
+		m_threads.emplace_back(&WorkerPool::WorkerThread, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_work_ready.notify_all();
+
+	for (std::thread& thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::Run(const std::vector<Job>& jobs)
+{
+	if (jobs.empty())
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobs = &jobs;
+	m_next_job = 0;
+	m_unfinished_jobs = jobs.size();
+	m_work_ready.notify_all();
+
+	m_work_done.wait(lock, [this]() { return m_unfinished_jobs == 0; });
+	m_jobs = nullptr;
+}
+
+void WorkerPool::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_work_ready.wait(lock, [this]() { return m_stopping || (m_jobs && m_next_job < m_jobs->size()); });
+		if (m_stopping)
+		{
+			return;
+		}
+
+		//Take the next job and run it without holding the lock
+		const Job& job = (*m_jobs)[m_next_job++];
+		lock.unlock();
+		job();
+		lock.lock();
+
+		if (--m_unfinished_jobs == 0)
+		{
+			m_work_done.notify_one();
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <SFML/System/NonCopyable.hpp>
+
+//A fixed set of threads that run a batch of jobs at a time. Run hands out the jobs and returns once all of them
+//have finished, so the caller knows nothing is still running when it carries on
+class WorkerPool : private sf::NonCopyable
+{
+public:
+	typedef std::function<void()> Job;
+
+public:
+	explicit WorkerPool(std::size_t thread_count);
+	~WorkerPool();
+
+	void Run(const std::vector<Job>& jobs);
+
+private:
+	void WorkerThread();
+
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_work_ready;
+	std::condition_variable m_work_done;
+
+	const std::vector<Job>* m_jobs;
+	std::size_t m_next_job;
+	std::size_t m_unfinished_jobs;
+	bool m_stopping;
+};
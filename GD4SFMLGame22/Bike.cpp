@@ -9,7 +9,6 @@
 #include "ResourceHolder.hpp"
 #include "Utility.hpp"
 #include "DataTables.hpp"
-#include "Pickup.hpp"
 #include "PickupType.hpp"
 #include "SoundNode.hpp"
 #include "NetworkNode.hpp"
@@ -41,6 +40,7 @@ Bike::Bike(BikeType type, const TextureHolder& textures, const FontHolder& fonts
 , m_directions_index(0)
 , m_identifier(0)
 , m_color_id(0)
+, m_network_driven(false)
 {
 	m_explosion.SetFrameSize(sf::Vector2i(256, 256));
 	m_explosion.SetNumFrames(16);
@@ -140,7 +140,11 @@ void Bike::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 {
 	UpdateTexts();
 	UpdateRollAnimation();
-	UpdateSpeed();
+	//A network driven bike is placed from outside, running the local speed curve as well would double it up
+	if (!m_network_driven)
+	{
+		UpdateSpeed();
+	}
 
 	if (IsHost() && IsHostDead())
 	{
@@ -184,7 +188,7 @@ void Bike::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 					node.NotifyGameAction(GameActions::EnemyExplode, position);
 				});
 
-				commands.Push(command);
+				commands.Push(std::move(command));
 			}
 
 			m_explosion_began = true;
@@ -192,6 +196,11 @@ void Bike::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 		return;
 	}
 
+	if (m_network_driven)
+	{
+		return;
+	}
+
 	// Update enemy movement pattern; apply velocity
 	UpdateMovementPattern(dt);
 	Entity::UpdateCurrent(dt, commands);
@@ -240,7 +249,7 @@ bool Bike::IsAllied() const
 	return m_type == BikeType::kRacer;
 }
 
-sf::FloatRect Bike::GetBoundingRect() const
+sf::FloatRect Bike::ComputeBoundingRect() const
 {
 	return GetWorldTransform().transformRect(m_sprite.getGlobalBounds());
 }
@@ -302,6 +311,7 @@ void Bike::UpdateRollAnimation()
 			textureRect.left += textureRect.width +1;
 
 		m_sprite.setTextureRect(textureRect);
+		InvalidateBoundingRect();
 	}
 }
 
@@ -317,7 +327,7 @@ void Bike::PlayLocalSound(CommandQueue& commands, SoundEffect effect)
 		node.PlaySound(effect, world_position);
 	});
 
-	commands.Push(command);
+	commands.Push(std::move(command));
 }
 
 
@@ -396,6 +406,30 @@ void Bike::DecreaseSpeed(float speedDown)
 		m_speed = 0;
 }
 
+void Bike::SetNetworkDriven(bool network_driven)
+{
+	m_network_driven = network_driven;
+}
+
+bool Bike::IsNetworkDriven() const
+{
+	return m_network_driven;
+}
+
+void Bike::SetInvincibility(bool isInvincible)
+{
+	//Keep a running countdown going, the server only reports when invincibility starts and ends
+	if (isInvincible && !m_invincibility)
+	{
+		m_invincible_counter = 1;
+	}
+	else if (!isInvincible)
+	{
+		m_invincible_counter = 0;
+	}
+	m_invincibility = isInvincible;
+}
+
 void Bike::SetBoost(bool hasBoost)
 {
 	m_boost_ready = hasBoost;
@@ -23,6 +23,9 @@ public:
 	void SetIdentifier(int identifier);
 	void SetBoost(bool hasBoost);
 	void SetInvincibility(bool isInvincible);
+	//Set for bikes whose position comes from prediction or snapshot interpolation instead of their own speed and velocity
+	void SetNetworkDriven(bool network_driven);
+	bool IsNetworkDriven() const;
 
 	void UseBoost();
 	void IncreaseSpeed(float speed);
@@ -37,7 +40,7 @@ public:
 	void UpdateMovementPattern(sf::Time dt);
 	float GetMaxSpeed() const;
 
-	sf::FloatRect GetBoundingRect() const override;
+	sf::FloatRect ComputeBoundingRect() const override;
 	bool IsMarkedForRemoval() const override;
 	void Remove() override;
 	void PlayLocalSound(CommandQueue& commands, SoundEffect effect);
@@ -84,6 +87,7 @@ private:
 
 	bool m_played_explosion_sound;
 	bool m_is_player1;
+	bool m_network_driven;
 
 	float m_max_speed;
 	TextNode* m_boost_display;
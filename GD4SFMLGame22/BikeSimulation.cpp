@@ -0,0 +1,95 @@
+#include "BikeSimulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "BikeType.hpp"
+#include "SimulationData.hpp"
+
+namespace
+{
+	const std::vector<BikeSimulationData> Table = InitializeBikeSimulationData();
+
+	//Counters count fixed 60Hz steps, like Bike's
+	const unsigned int kBoostDuration = 250;
+	const float kBorderDistance = 40.f;
+	const float kBarrierDistance = 650.f;
+	const float kOffscreenAmount = 400.f;
+}
+
+BikeMotion::BikeMotion()
+	: m_position()
+	, m_velocity()
+	, m_speed(0.f)
+	, m_boost(true)
+	, m_using_boost(false)
+	, m_boost_counter(0)
+{
+}
+
+InputBits ToInputBit(PlayerAction action)
+{
+	return static_cast<InputBits>(1 << static_cast<int>(action));
+}
+
+void StepBike(BikeMotion& motion, InputBits input, sf::Time dt)
+{
+	float max_speed = Table[static_cast<int>(BikeType::kRacer)].m_max_speed;
+	float max_speed_boost = max_speed / 100.f;
+
+	if ((input & ToInputBit(PlayerAction::kBoost)) && motion.m_boost && !motion.m_using_boost)
+	{
+		motion.m_boost = false;
+		motion.m_using_boost = true;
+	}
+
+	if (motion.m_using_boost)
+	{
+		motion.m_speed += max_speed_boost;
+		if (++motion.m_boost_counter > kBoostDuration)
+		{
+			motion.m_using_boost = false;
+			motion.m_boost_counter = 0;
+		}
+	}
+
+	if (motion.m_speed < 100.f)
+	{
+		motion.m_speed += max_speed_boost;
+	}
+	else if (motion.m_speed < max_speed)
+	{
+		motion.m_speed += max_speed_boost / 10.f;
+	}
+	else if (!motion.m_using_boost && motion.m_speed > max_speed)
+	{
+		motion.m_speed -= max_speed_boost;
+	}
+
+	sf::Vector2f direction;
+	if (input & ToInputBit(PlayerAction::kMoveLeft))
+		direction.x -= 1.f;
+	if (input & ToInputBit(PlayerAction::kMoveRight))
+		direction.x += 1.f;
+	if (input & ToInputBit(PlayerAction::kMoveUp))
+		direction.y -= 1.f;
+	if (input & ToInputBit(PlayerAction::kMoveDown))
+		direction.y += 1.f;
+
+	motion.m_velocity = direction * motion.m_speed;
+	//If moving diagonally then reduce velocity
+	if (motion.m_velocity.x != 0.f && motion.m_velocity.y != 0.f)
+	{
+		motion.m_velocity /= std::sqrt(2.f);
+	}
+	motion.m_position += motion.m_velocity * dt.asSeconds();
+}
+
+void KeepBikeOnScreen(BikeMotion& motion, float view_left, float view_width, float battlefield_bottom)
+{
+	motion.m_position.x = std::max(motion.m_position.x, view_left - kOffscreenAmount);
+	motion.m_position.x = std::min(motion.m_position.x, view_left + view_width - kBorderDistance);
+	motion.m_position.y = std::max(motion.m_position.y, kBarrierDistance);
+	motion.m_position.y = std::min(motion.m_position.y, battlefield_bottom - kBorderDistance);
+}
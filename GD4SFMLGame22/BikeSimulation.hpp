@@ -0,0 +1,38 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "PlayerAction.hpp"
+
+//The part of a bike's state that follows from its player's input. It is stepped the same way by the server's
+//ServerWorld and by a client predicting its own bikes, so replaying the same inputs reproduces the same motion
+
+//The fixed step both the server and the clients simulate at, snapshot ticks count these
+const sf::Time kSimulationStep = sf::seconds(1.f / 60.f);
+
+//Bit 1 << PlayerAction is set for every action held during one fixed step
+typedef sf::Uint8 InputBits;
+
+struct InputCommand
+{
+	sf::Uint32 m_sequence;
+	InputBits m_input;
+};
+
+struct BikeMotion
+{
+	BikeMotion();
+	sf::Vector2f m_position;
+	sf::Vector2f m_velocity;
+	float m_speed;
+	bool m_boost;
+	bool m_using_boost;
+	unsigned int m_boost_counter;
+};
+
+InputBits ToInputBit(PlayerAction action);
+//Speed and boost as Bike::UpdateSpeed, movement as the player's BikeMover commands and World::AdaptPlayerVelocity
+void StepBike(BikeMotion& motion, InputBits input, sf::Time dt);
+//Same limits as World::AdaptPlayerPosition for a view starting at view_left
+void KeepBikeOnScreen(BikeMotion& motion, float view_left, float view_width, float battlefield_bottom);
@@ -5,3 +5,76 @@ Command::Command()
 {
 	
 }
+
+CommandAction::CommandAction()
+	: m_operations(nullptr)
+{
+}
+
+CommandAction::CommandAction(const CommandAction& other)
+	: m_operations(other.m_operations)
+{
+	if (m_operations)
+	{
+		m_operations->copy(m_storage, other.m_storage);
+	}
+}
+
+CommandAction::CommandAction(CommandAction&& other)
+	: m_operations(other.m_operations)
+{
+	if (m_operations)
+	{
+		m_operations->move(m_storage, other.m_storage);
+		other.Reset();
+	}
+}
+
+CommandAction& CommandAction::operator=(const CommandAction& other)
+{
+	if (this != &other)
+	{
+		Reset();
+		if (other.m_operations)
+		{
+			other.m_operations->copy(m_storage, other.m_storage);
+			m_operations = other.m_operations;
+		}
+	}
+	return *this;
+}
+
+CommandAction& CommandAction::operator=(CommandAction&& other)
+{
+	if (this != &other)
+	{
+		Reset();
+		if (other.m_operations)
+		{
+			other.m_operations->move(m_storage, other.m_storage);
+			m_operations = other.m_operations;
+			other.Reset();
+		}
+	}
+	return *this;
+}
+
+CommandAction::~CommandAction()
+{
+	Reset();
+}
+
+void CommandAction::operator()(SceneNode& node, sf::Time dt) const
+{
+	assert(m_operations);
+	m_operations->invoke(m_storage, node, dt);
+}
+
+void CommandAction::Reset()
+{
+	if (m_operations)
+	{
+		m_operations->destroy(m_storage);
+		m_operations = nullptr;
+	}
+}
@@ -1,30 +1,72 @@
 #pragma once
 #include "Category.hpp"
 #include <SFML/System/Time.hpp>
-#include <functional>
+#include <cstddef>
 #include <cassert>
 
 class SceneNode;
 
+//What a command does to each node it is given to. The function object lives inside the action, so copying or
+//queuing a command never allocates; a function object too big for it does not compile
+class CommandAction
+{
+public:
+	static const std::size_t kStorageSize = 32;
+
+public:
+	CommandAction();
+	template <typename Function>
+	explicit CommandAction(Function fn);
+	CommandAction(const CommandAction& other);
+	CommandAction(CommandAction&& other);
+	CommandAction& operator=(const CommandAction& other);
+	CommandAction& operator=(CommandAction&& other);
+	~CommandAction();
+
+	void operator()(SceneNode& node, sf::Time dt) const;
+
+private:
+	struct Operations
+	{
+		void(*invoke)(const void* function, SceneNode& node, sf::Time dt);
+		void(*copy)(void* destination, const void* source);
+		void(*move)(void* destination, void* source);
+		void(*destroy)(void* function);
+	};
+
+	template <typename Function>
+	struct FunctionOperations
+	{
+		static void Invoke(const void* function, SceneNode& node, sf::Time dt);
+		static void Copy(void* destination, const void* source);
+		static void Move(void* destination, void* source);
+		static void Destroy(void* function);
+
+		static const Operations kOperations;
+	};
+
+	void Reset();
+
+private:
+	const Operations* m_operations;
+	alignas(std::max_align_t) unsigned char m_storage[kStorageSize];
+};
+
 struct Command
 {
 	Command();
-	std::function<void(SceneNode&, sf::Time)> action;
+	CommandAction action;
 	unsigned int category;
 };
 
+//The command's category says which nodes it reaches, so the node is cast to the type those nodes are
 template<typename GameObject, typename Function>
-std::function<void(SceneNode&, sf::Time)> DerivedAction(Function fn)
+CommandAction DerivedAction(Function fn)
 {
-	return [=](SceneNode& node, sf::Time dt)
+	return CommandAction([fn](SceneNode& node, sf::Time dt)
 	{
-		//Check if cast is safe
-		assert(dynamic_cast<GameObject*>(&node) != nullptr);
-
-		//Downcast node and invoke the function
 		fn(static_cast<GameObject&>(node), dt);
-	};
+	});
 }
 
-
-
+#include "Command.inl"
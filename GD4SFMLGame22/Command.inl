@@ -0,0 +1,44 @@
+#include <new>
+#include <utility>
+
+template <typename Function>
+CommandAction::CommandAction(Function fn)
+	: m_operations(&FunctionOperations<Function>::kOperations)
+{
+	static_assert(sizeof(Function) <= kStorageSize, "Command action captures too much, capture less or raise kStorageSize");
+	static_assert(alignof(Function) <= alignof(std::max_align_t), "Command action captures an over-aligned type");
+	new (m_storage) Function(std::move(fn));
+}
+
+template <typename Function>
+void CommandAction::FunctionOperations<Function>::Invoke(const void* function, SceneNode& node, sf::Time dt)
+{
+	(*static_cast<const Function*>(function))(node, dt);
+}
+
+template <typename Function>
+void CommandAction::FunctionOperations<Function>::Copy(void* destination, const void* source)
+{
+	new (destination) Function(*static_cast<const Function*>(source));
+}
+
+template <typename Function>
+void CommandAction::FunctionOperations<Function>::Move(void* destination, void* source)
+{
+	new (destination) Function(std::move(*static_cast<Function*>(source)));
+}
+
+template <typename Function>
+void CommandAction::FunctionOperations<Function>::Destroy(void* function)
+{
+	static_cast<Function*>(function)->~Function();
+}
+
+template <typename Function>
+const CommandAction::Operations CommandAction::FunctionOperations<Function>::kOperations =
+{
+	&CommandAction::FunctionOperations<Function>::Invoke,
+	&CommandAction::FunctionOperations<Function>::Copy,
+	&CommandAction::FunctionOperations<Function>::Move,
+	&CommandAction::FunctionOperations<Function>::Destroy
+};
@@ -0,0 +1,49 @@
+#include "CommandLine.hpp"
+
+#include <stdexcept>
+
+bool CommandLine::ParseUnsigned(const std::string& value, unsigned long min, unsigned long max, unsigned long& result)
+{
+	//stoul takes a minus sign and wraps the number around instead of failing
+	if (value.find('-') != std::string::npos)
+	{
+		return false;
+	}
+
+	try
+	{
+		std::size_t parsed_length;
+		unsigned long parsed = std::stoul(value, &parsed_length, 10);
+		if (parsed_length != value.size() || parsed < min || parsed > max)
+		{
+			return false;
+		}
+		result = parsed;
+		return true;
+	}
+	catch (const std::logic_error&)
+	{
+		//invalid_argument for no number at all, out_of_range for one too large for unsigned long
+		return false;
+	}
+}
+
+bool CommandLine::ParseFloat(const std::string& value, float min, float max, float& result)
+{
+	try
+	{
+		std::size_t parsed_length;
+		float parsed = std::stof(value, &parsed_length);
+		//Written so that NaN fails the range check too
+		if (parsed_length != value.size() || !(parsed >= min && parsed <= max))
+		{
+			return false;
+		}
+		result = parsed;
+		return true;
+	}
+	catch (const std::logic_error&)
+	{
+		return false;
+	}
+}
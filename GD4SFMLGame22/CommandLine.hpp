@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+//Argument parsing for the headless server and bots. A value is only accepted if all of it is a number within the
+//range, so a typo or an out of range value is reported rather than quietly becoming 0 or wrapping around
+class CommandLine
+{
+public:
+	static bool ParseUnsigned(const std::string& value, unsigned long min, unsigned long max, unsigned long& result);
+	static bool ParseFloat(const std::string& value, float min, float max, float& result);
+};
@@ -1,18 +1,59 @@
 #include "CommandQueue.hpp"
 
+#include <utility>
+
+namespace
+{
+	//Power of two, so slots are found with a mask
+	const std::size_t kInitialCapacity = 64;
+}
+
+CommandQueue::CommandQueue()
+	: m_commands(kInitialCapacity)
+	, m_head(0)
+	, m_size(0)
+{
+}
+
 void CommandQueue::Push(const Command& command)
 {
-	m_queue.push(command);
+	GetFreeSlot() = command;
+}
+
+void CommandQueue::Push(Command&& command)
+{
+	GetFreeSlot() = std::move(command);
 }
 
 Command CommandQueue::Pop()
 {
-	Command command = m_queue.front();
-	m_queue.pop();
+	assert(m_size > 0);
+	Command command = std::move(m_commands[m_head]);
+	m_head = (m_head + 1) & (m_commands.size() - 1);
+	--m_size;
 	return command;
 }
 
 bool CommandQueue::IsEmpty() const
 {
-	return m_queue.empty();
+	return m_size == 0;
+}
+
+Command& CommandQueue::GetFreeSlot()
+{
+	if (m_size == m_commands.size())
+	{
+		//Unwrapped into a buffer twice the size, oldest first
+		std::vector<Command> commands(m_commands.size() * 2);
+		for (std::size_t i = 0; i < m_size; ++i)
+		{
+			commands[i] = std::move(m_commands[(m_head + i) & (m_commands.size() - 1)]);
+		}
+		m_commands.swap(commands);
+		m_head = 0;
+	}
+
+	Command& slot = m_commands[(m_head + m_size) & (m_commands.size() - 1)];
+	++m_size;
+	return slot;
 }
@@ -1,15 +1,23 @@
 #pragma once
 #include "Command.hpp"
-#include <queue>
+#include <vector>
 // TODO Make CommandQueue class a Singleton
+//A ring buffer of commands. Its slots are reused from frame to frame, it only allocates when a frame queues more
+//commands than any frame before it
 class CommandQueue
 {
 public:
+	CommandQueue();
 	void Push(const Command& command);
+	void Push(Command&& command);
 	Command Pop();
 	bool IsEmpty() const;
 
 private:
-	std::queue<Command> m_queue;
-};
+	Command& GetFreeSlot();
 
+private:
+	std::vector<Command> m_commands;
+	std::size_t m_head;
+	std::size_t m_size;
+};
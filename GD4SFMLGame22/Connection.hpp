@@ -0,0 +1,86 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "MessageWriter.hpp"
+
+//How a message sent over a Connection is delivered
+enum class Delivery
+{
+	//May be lost; a message older than one already received is dropped. Used for position and state snapshots
+	kUnreliableSequenced,
+	//Resent until acknowledged and handed to the receiver in the order it was sent. Used for events
+	kReliableOrdered
+};
+
+//Running totals a connection keeps of what it sent and received, NetworkStatistics turns them into rates
+struct ConnectionTraffic
+{
+	ConnectionTraffic()
+		: m_datagrams_sent(0)
+		, m_datagrams_acked(0)
+		, m_datagrams_lost(0)
+		, m_bytes_sent(0)
+		, m_bytes_received(0)
+	{
+	}
+
+	std::size_t m_datagrams_sent;
+	std::size_t m_datagrams_acked;
+	//Sent datagrams that went unacknowledged for too long
+	std::size_t m_datagrams_lost;
+	std::size_t m_bytes_sent;
+	std::size_t m_bytes_received;
+};
+
+//Serialized bytes of one message. Shared, so a message queued on many connections is only copied once
+typedef std::shared_ptr<const std::vector<char>> MessagePayload;
+
+//Message based link between a client and the server. GameServer, MultiplayerGameState and Player
+//only talk through this interface so the transport underneath can change
+class Connection
+{
+public:
+	virtual ~Connection() = default;
+
+	static MessagePayload MakePayload(const char* data, std::size_t size)
+	{
+		return std::make_shared<const std::vector<char>>(data, data + size);
+	}
+
+	static MessagePayload MakePayload(const sf::Packet& packet)
+	{
+		return MakePayload(static_cast<const char*>(packet.getData()), packet.getDataSize());
+	}
+
+	static MessagePayload MakePayload(const MessageWriter& writer)
+	{
+		return MakePayload(writer.GetData(), writer.GetSize());
+	}
+
+	//Messages are only queued by Send, everything queued goes out together on the next Flush.
+	//A message too large for the transport is dropped
+	void Send(const sf::Packet& packet, Delivery delivery)
+	{
+		Send(static_cast<const char*>(packet.getData()), packet.getDataSize(), delivery);
+	}
+
+	void Send(const MessageWriter& writer, Delivery delivery)
+	{
+		Send(writer.GetData(), writer.GetSize(), delivery);
+	}
+
+	virtual void Send(const MessagePayload& payload, Delivery delivery) = 0;
+	//Copies the bytes, so the caller can reuse its buffer straight away. Unlike a MessagePayload this does not
+	//allocate for unreliable messages, which is what snapshots and inputs are sent as every tick
+	virtual void Send(const char* data, std::size_t size, Delivery delivery) = 0;
+	virtual void Flush() = 0;
+	virtual bool Receive(sf::Packet& packet) = 0;
+	virtual bool IsConnected() const = 0;
+	//How long the other end has been quiet, used to time out peers that vanished without saying goodbye
+	virtual sf::Time GetTimeSinceLastReceive() const = 0;
+	virtual const ConnectionTraffic& GetTraffic() const = 0;
+};
@@ -5,14 +5,17 @@
 #include "ParticleType.hpp"
 #include "PickupType.hpp"
 #include "ProjectileType.hpp"
+#include "SimulationData.hpp"
 
 std::vector<BikeData> InitializeBikeData()
 {
 	std::vector<BikeData> data(static_cast<int>(BikeType::kBikeCount));
+	//Values the server simulates with come from the shared table so both sides agree
+	std::vector<BikeSimulationData> simulation = InitializeBikeSimulationData();
 
-	data[static_cast<int>(BikeType::kRacer)].m_hitpoints = 100;
+	data[static_cast<int>(BikeType::kRacer)].m_hitpoints = simulation[static_cast<int>(BikeType::kRacer)].m_hitpoints;
 	data[static_cast<int>(BikeType::kRacer)].m_speed = 250.f;
-	data[static_cast<int>(BikeType::kRacer)].m_max_speed = 450.f;
+	data[static_cast<int>(BikeType::kRacer)].m_max_speed = simulation[static_cast<int>(BikeType::kRacer)].m_max_speed;
 	data[static_cast<int>(BikeType::kRacer)].m_texture = Textures::kBikeSpriteSheet;
 	data[static_cast<int>(BikeType::kRacer)].m_texture_rect = sf::IntRect(58, 0, 57, 29);
 	data[static_cast<int>(BikeType::kRacer)].m_has_roll_animation = true;
@@ -24,18 +27,19 @@ std::vector<BikeData> InitializeBikeData()
 std::vector<ObstacleData> InitializeObstacleData()
 {
 	std::vector<ObstacleData> data(static_cast<int>(ObstacleType::kObstacleCount));
+	std::vector<ObstacleSimulationData> simulation = InitializeObstacleSimulationData();
 
 	data[static_cast<int>(ObstacleType::kTarSpill)].m_texture = Textures::kSpriteSheet;
 	data[static_cast<int>(ObstacleType::kTarSpill)].m_texture_rect = sf::IntRect(123, 153, 45, 19);
-	data[static_cast<int>(ObstacleType::kTarSpill)].m_slow_down_amount = 0.4f;
+	data[static_cast<int>(ObstacleType::kTarSpill)].m_slow_down_amount = simulation[static_cast<int>(ObstacleType::kTarSpill)].m_slow_down_amount;
 
 	data[static_cast<int>(ObstacleType::kAcidSpill)].m_texture = Textures::kSpriteSheet;
 	data[static_cast<int>(ObstacleType::kAcidSpill)].m_texture_rect = sf::IntRect(124, 132, 45, 19);
-	data[static_cast<int>(ObstacleType::kAcidSpill)].m_slow_down_amount = 0.2f;
+	data[static_cast<int>(ObstacleType::kAcidSpill)].m_slow_down_amount = simulation[static_cast<int>(ObstacleType::kAcidSpill)].m_slow_down_amount;
 
 	data[static_cast<int>(ObstacleType::kBarrier)].m_texture = Textures::kSpriteSheet;
 	data[static_cast<int>(ObstacleType::kBarrier)].m_texture_rect = sf::IntRect(182, 86, 17, 29);
-	data[static_cast<int>(ObstacleType::kBarrier)].m_slow_down_amount = 0.9f;
+	data[static_cast<int>(ObstacleType::kBarrier)].m_slow_down_amount = simulation[static_cast<int>(ObstacleType::kBarrier)].m_slow_down_amount;
 	return data;
 }
 
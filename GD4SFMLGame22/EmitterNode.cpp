@@ -31,7 +31,7 @@ void EmitterNode::UpdateCurrent(sf::Time dt, CommandQueue& commands)
 		command.category = Category::kParticleSystem;
 		command.action = DerivedAction<ParticleNode>(finder);
 
-		commands.Push(command);
+		commands.Push(std::move(command));
 	}
 }
 
@@ -0,0 +1,205 @@
+#include "EntityStore.hpp"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/View.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+#include "Bike.hpp"
+#include "DataTables.hpp"
+#include "ResourceHolder.hpp"
+
+namespace
+{
+	const std::vector<ObstacleData> ObstacleTable = InitializeObstacleData();
+	const std::vector<PickupData> PickupTable = InitializePickupData();
+
+	const int kObstacleHitpoints = 100;
+	const int kPickupHitpoints = 1;
+}
+
+EntityStore::EntityStore(const TextureHolder& textures)
+	: SceneNode()
+	, m_textures(textures)
+{
+}
+
+std::size_t EntityStore::AddObstacle(ObstacleType type, sf::Vector2f position)
+{
+	const ObstacleData& data = ObstacleTable[static_cast<int>(type)];
+	return AddEntity(Category::kObstacle, static_cast<sf::Uint8>(type), kObstacleHitpoints, position, sf::Vector2f(), data.m_texture, data.m_texture_rect);
+}
+
+std::size_t EntityStore::AddPickup(PickupType type, sf::Vector2f position, sf::Vector2f velocity)
+{
+	const PickupData& data = PickupTable[static_cast<int>(type)];
+	return AddEntity(Category::kPickup, static_cast<sf::Uint8>(type), kPickupHitpoints, position, velocity, data.m_texture, data.m_texture_rect);
+}
+
+std::size_t EntityStore::AddEntity(unsigned int category, sf::Uint8 type, int hitpoints, sf::Vector2f position, sf::Vector2f velocity, Textures texture, const sf::IntRect& texture_rect)
+{
+	//Sprites are centred on their position
+	sf::Vector2f size(static_cast<float>(texture_rect.width), static_cast<float>(texture_rect.height));
+	sf::Vector2f top_left = position - size / 2.f;
+
+	m_positions.emplace_back(position);
+	m_velocities.emplace_back(velocity);
+	m_bounds.emplace_back(top_left.x, top_left.y, size.x, size.y);
+	m_hitpoints.emplace_back(hitpoints);
+	m_categories.emplace_back(category);
+	m_types.emplace_back(type);
+	m_sprite_textures.emplace_back(&m_textures.Get(texture));
+	m_texture_rects.emplace_back(texture_rect);
+	return m_positions.size() - 1;
+}
+
+void EntityStore::DestroyOutside(const sf::FloatRect& bounds)
+{
+	for (std::size_t i = 0; i < m_bounds.size(); ++i)
+	{
+		if (!bounds.intersects(m_bounds[i]))
+		{
+			m_hitpoints[i] = 0;
+		}
+	}
+}
+
+void EntityStore::RemoveDestroyed()
+{
+	//Compacted in place, so the survivors keep their order and the arrays their capacity
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < m_hitpoints.size(); ++i)
+	{
+		if (m_hitpoints[i] <= 0)
+		{
+			continue;
+		}
+		if (kept != i)
+		{
+			m_positions[kept] = m_positions[i];
+			m_velocities[kept] = m_velocities[i];
+			m_bounds[kept] = m_bounds[i];
+			m_hitpoints[kept] = m_hitpoints[i];
+			m_categories[kept] = m_categories[i];
+			m_types[kept] = m_types[i];
+			m_sprite_textures[kept] = m_sprite_textures[i];
+			m_texture_rects[kept] = m_texture_rects[i];
+		}
+		++kept;
+	}
+
+	m_positions.resize(kept);
+	m_velocities.resize(kept);
+	m_bounds.resize(kept);
+	m_hitpoints.resize(kept);
+	m_categories.resize(kept);
+	m_types.resize(kept);
+	m_sprite_textures.resize(kept);
+	m_texture_rects.resize(kept);
+}
+
+void EntityStore::FindOverlaps(const sf::FloatRect& rect, unsigned int categories, std::vector<std::size_t>& overlaps) const
+{
+	for (std::size_t i = 0; i < m_bounds.size(); ++i)
+	{
+		if ((m_categories[i] & categories) && m_hitpoints[i] > 0 && rect.intersects(m_bounds[i]))
+		{
+			overlaps.emplace_back(i);
+		}
+	}
+}
+
+std::size_t EntityStore::GetEntityCount() const
+{
+	return m_positions.size();
+}
+
+unsigned int EntityStore::GetEntityCategory(std::size_t entity) const
+{
+	return m_categories[entity];
+}
+
+const sf::FloatRect& EntityStore::GetEntityBounds(std::size_t entity) const
+{
+	return m_bounds[entity];
+}
+
+bool EntityStore::IsEntityDestroyed(std::size_t entity) const
+{
+	return m_hitpoints[entity] <= 0;
+}
+
+void EntityStore::DestroyEntity(std::size_t entity)
+{
+	m_hitpoints[entity] = 0;
+}
+
+float EntityStore::GetSlowdown(std::size_t obstacle) const
+{
+	assert(m_categories[obstacle] == Category::kObstacle);
+	return ObstacleTable[m_types[obstacle]].m_slow_down_amount;
+}
+
+void EntityStore::ApplyPickup(std::size_t pickup, Bike& bike) const
+{
+	assert(m_categories[pickup] == Category::kPickup);
+	PickupTable[m_types[pickup]].m_action(bike);
+}
+
+void EntityStore::UpdateCurrent(sf::Time dt, CommandQueue&)
+{
+	float seconds = dt.asSeconds();
+	for (std::size_t i = 0; i < m_positions.size(); ++i)
+	{
+		sf::Vector2f offset = m_velocities[i] * seconds;
+		m_positions[i] += offset;
+		m_bounds[i].left += offset.x;
+		m_bounds[i].top += offset.y;
+	}
+}
+
+void EntityStore::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	const sf::View& view = target.getView();
+	sf::FloatRect view_bounds(view.getCenter() - view.getSize() / 2.f, view.getSize());
+
+	for (Batch& batch : m_batches)
+	{
+		batch.m_vertices.clear();
+	}
+
+	for (std::size_t i = 0; i < m_bounds.size(); ++i)
+	{
+		const sf::FloatRect& bounds = m_bounds[i];
+		if (!view_bounds.intersects(bounds))
+		{
+			continue;
+		}
+
+		//A handful of textures at most, so a linear search finds the batch
+		auto batch = std::find_if(m_batches.begin(), m_batches.end(), [&](const Batch& b) {return b.m_texture == m_sprite_textures[i]; });
+		if (batch == m_batches.end())
+		{
+			m_batches.emplace_back(Batch{ m_sprite_textures[i], sf::VertexArray(sf::Quads) });
+			batch = m_batches.end() - 1;
+		}
+
+		const sf::IntRect& rect = m_texture_rects[i];
+		float left = static_cast<float>(rect.left);
+		float top = static_cast<float>(rect.top);
+		float right = left + rect.width;
+		float bottom = top + rect.height;
+		batch->m_vertices.append(sf::Vertex(sf::Vector2f(bounds.left, bounds.top), sf::Vector2f(left, top)));
+		batch->m_vertices.append(sf::Vertex(sf::Vector2f(bounds.left + bounds.width, bounds.top), sf::Vector2f(right, top)));
+		batch->m_vertices.append(sf::Vertex(sf::Vector2f(bounds.left + bounds.width, bounds.top + bounds.height), sf::Vector2f(right, bottom)));
+		batch->m_vertices.append(sf::Vertex(sf::Vector2f(bounds.left, bounds.top + bounds.height), sf::Vector2f(left, bottom)));
+	}
+
+	for (const Batch& batch : m_batches)
+	{
+		states.texture = batch.m_texture;
+		target.draw(batch.m_vertices, states);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include "ObstacleType.hpp"
+#include "PickupType.hpp"
+#include "ResourceIdentifiers.hpp"
+#include "SceneNode.hpp"
+
+class Bike;
+
+//Obstacles and pickups, kept as one array per component rather than one node each, so that a long track's
+//thousands of them are moved, culled and checked for collisions by plain loops and drawn in one batch per texture.
+//Positions are world positions, so the store sits unmoved at the scene's origin. An entity is its index, which
+//stays valid until the next RemoveDestroyed
+class EntityStore : public SceneNode
+{
+public:
+	explicit EntityStore(const TextureHolder& textures);
+
+	std::size_t AddObstacle(ObstacleType type, sf::Vector2f position);
+	std::size_t AddPickup(PickupType type, sf::Vector2f position, sf::Vector2f velocity = sf::Vector2f());
+
+	//Destroys the entities that no longer intersect the bounds
+	void DestroyOutside(const sf::FloatRect& bounds);
+	void RemoveDestroyed();
+	//Appends the live entities of one of the categories whose bounds intersect the rect
+	void FindOverlaps(const sf::FloatRect& rect, unsigned int categories, std::vector<std::size_t>& overlaps) const;
+
+	std::size_t GetEntityCount() const;
+	unsigned int GetEntityCategory(std::size_t entity) const;
+	const sf::FloatRect& GetEntityBounds(std::size_t entity) const;
+	bool IsEntityDestroyed(std::size_t entity) const;
+	void DestroyEntity(std::size_t entity);
+
+	float GetSlowdown(std::size_t obstacle) const;
+	void ApplyPickup(std::size_t pickup, Bike& bike) const;
+
+private:
+	std::size_t AddEntity(unsigned int category, sf::Uint8 type, int hitpoints, sf::Vector2f position, sf::Vector2f velocity, Textures texture, const sf::IntRect& texture_rect);
+
+	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands) override;
+	virtual void DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+	struct Batch
+	{
+		const sf::Texture* m_texture;
+		sf::VertexArray m_vertices;
+	};
+
+private:
+	const TextureHolder& m_textures;
+
+	std::vector<sf::Vector2f> m_positions;
+	std::vector<sf::Vector2f> m_velocities;
+	//World bounds, moved along with the position
+	std::vector<sf::FloatRect> m_bounds;
+	std::vector<int> m_hitpoints;
+	std::vector<unsigned int> m_categories;
+	//ObstacleType or PickupType, depending on the category
+	std::vector<sf::Uint8> m_types;
+	std::vector<const sf::Texture*> m_sprite_textures;
+	std::vector<sf::IntRect> m_texture_rects;
+
+	//Rebuilt every draw from the entities in view, their vertices are reused
+	mutable std::vector<Batch> m_batches;
+};
@@ -1,5 +1,7 @@
 #include "GameServer.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include "NetworkProtocol.hpp"
@@ -7,62 +9,220 @@
 
 #include <SFML/Network/Packet.hpp>
 
-#include "Bike.hpp"
+#include "MessageWriter.hpp"
 #include "PickupType.hpp"
-#include "Utility.hpp"
 
-//It is essential to set the sockets to non-blocking - m_socket.setBlocking(false)
-//otherwise the server will hang waiting to read input from a connection
+namespace
+{
+	//A visible bike is only dropped once it is this much further out than the interest radius
+	const float kInterestHysteresis = 1.25f;
+	//How far beyond the frontmost bike the track is laid out in the server's world
+	const float kTrackLookahead = 1500.f;
+	const sf::Time kStatisticsWriteInterval = sf::seconds(1.f);
+	//A congested peer is sent a snapshot at least every this many ticks
+	const std::size_t kMaxSnapshotInterval = 4;
+	//Entries of the join snapshot a joining peer is sent per tick
+	const std::size_t kJoinSnapshotEntries = 32;
+	//Without a wake signal, local connections do not wake the socket selector, so with one connected it is polled this often
+	const sf::Time kLocalPollInterval = sf::milliseconds(4);
+	//The battlefield's top keeps moving up through the race, so the clients' ratio eventually stops meaning anything.
+	//The server's world never scrolls slower or faster than this
+	const float kMinScrollCompensation = 0.5f;
+	const float kMaxScrollCompensation = 2.f;
+
+	//Finds where a chunk starting at first ends, counting only the entries the filter passes up to the budget
+	template <typename Iterator, typename Filter>
+	Iterator FindChunkEnd(Iterator first, Iterator end, std::size_t budget, Filter filter, std::size_t& count)
+	{
+		count = 0;
+		for (; first != end && count < budget; ++first)
+		{
+			if (filter(*first))
+			{
+				++count;
+			}
+		}
+		return first;
+	}
+
+	TrackSettings MakeTrackSettings(sf::Uint32 seed, float difficulty, float length)
+	{
+		TrackSettings track;
+		track.m_seed = seed;
+		track.m_difficulty = difficulty;
+		track.m_length = length;
+		return track;
+	}
+
+	float GetScrollCompensation(float battlefield_top, float battlefield_height)
+	{
+		float world_position = battlefield_top + battlefield_height;
+		if (world_position <= 0.f)
+		{
+			return kMaxScrollCompensation;
+		}
+		return std::min(std::max(battlefield_height / world_position, kMinScrollCompensation), kMaxScrollCompensation);
+	}
+}
+
+//All peers share the UdpHost's socket, which is non-blocking, so the server never hangs waiting on a connection
+
+ServerSettings::ServerSettings()
+	: m_port(SERVER_PORT)
+	, m_max_connected_players(15)
+	, m_tick_rate(sf::seconds(1.f / 15.f))
+	, m_simulated_loss(0.f)
+	, m_interest_radius(2000.f)
+	, m_peer_bandwidth(32000.f)
+	, m_track_difficulty(1.f)
+	, m_random_seed(0)
+{
+}
+
+GameServer::RemotePeer::RemotePeer():m_connection(nullptr), m_identifier(0), m_send_rate(1, 0.f), m_acked_snapshot(0), m_joining(false), m_join_section(Server::JoinSnapshotSection::kBikes), m_join_cursor(0), m_ready(false), m_timed_out(false)
+{
+}
 
-GameServer::RemotePeer::RemotePeer():m_ready(false), m_timed_out(false)
+GameServer::GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings)
+	: GameServer(battlefield_size, settings, nullptr)
 {
-	m_socket.setBlocking(false);
+	m_host.SetSimulatedLoss(settings.m_simulated_loss);
+	//Bound here, before the thread starts, so ConnectLocal on the host's thread never sees it change
+	m_local_wake = std::make_shared<WakeSignal>();
+	if (!m_local_wake->Bind())
+	{
+		std::cout << "Server could not bind a wake signal, local connections are polled" << std::endl;
+		m_local_wake.reset();
+	}
+	m_thread.launch();
 }
 
-GameServer::GameServer(sf::Vector2f battlefield_size)
+GameServer::GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings, UdpHost& shared_host)
+	: GameServer(battlefield_size, settings, &shared_host)
+{
+	SetListening(true);
+}
+
+GameServer::GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings, UdpHost* shared_host)
 	: m_thread(&GameServer::ExecutionThread, this)
+	, m_own_host(shared_host ? nullptr : new UdpHost())
+	, m_host(shared_host ? *shared_host : *m_own_host)
+	, m_local_handoff(4)
+	, m_port(settings.m_port)
 	, m_listening_state(false)
 	, m_client_timeout(sf::seconds(1.f))
-	, m_max_connected_players(15)
+	, m_tick_rate(settings.m_tick_rate)
+	, m_interest_radius(settings.m_interest_radius)
+	, m_peer_bandwidth(settings.m_peer_bandwidth)
+	, m_frame_time(sf::Time::Zero)
+	, m_tick_time(sf::Time::Zero)
+	, m_match_time(sf::Time::Zero)
+	, m_since_ping(sf::Time::Zero)
+	, m_since_statistics_write(sf::Time::Zero)
+	, m_peer_counter(0)
+	, m_max_connected_players(std::max<std::size_t>(settings.m_max_connected_players, 1))
 	, m_connected_players(0)
 	, m_world_width(12000.0f)
-	, m_battlefield_rect(0.f, 0.f, m_world_width, 1017)
+	, m_battlefield_top(0.f)
+	, m_battlefield_height(1017)
 	, m_battlefield_scrollspeed(-5.f)
-	, m_bike_count(0)
+	, m_world(battlefield_size, m_battlefield_height)
 	, m_peers(1)
 	, m_bike_identifier_counter(1)
-	, m_waiting_thread_end(false)
-	, m_last_spawn_time(sf::Time::Zero)
-	, m_time_for_next_spawn(sf::seconds(5.f))
-	, m_last_pickup_spawn_time(sf::Time::Zero)
-	, m_time_for_next_pickup_spawn(sf::seconds(15.f))
 	, m_x_bounds(1500)
+	, m_waiting_thread_end(false)
 	, m_in_lobby(true)
+	, m_random_seed(settings.m_random_seed != 0 ? settings.m_random_seed : RandomStream::SeedFromClock())
+	, m_drop_random(m_random_seed, RandomStreamId::kDrops)
+	, m_track(MakeTrackSettings(m_random_seed, settings.m_track_difficulty, m_world_width))
+	, m_snapshot_codec(sf::Vector2f(m_world_width, m_battlefield_height))
+	, m_snapshot_sequence(0)
 {
-	m_listener_socket.setBlocking(false);
 	m_peers[0].reset(new RemotePeer());
-	m_thread.launch();
+	//Room for a bike per player, coop partners grow it once
+	m_snapshot.m_bikes.reserve(m_max_connected_players);
+
+	if (!settings.m_record_path.empty())
+	{
+		MatchRecordingHeader header;
+		header.m_battlefield_size = battlefield_size;
+		header.m_random_seed = m_random_seed;
+		header.m_tick_rate = m_tick_rate;
+		header.m_max_connected_players = static_cast<sf::Uint32>(m_max_connected_players);
+		header.m_interest_radius = m_interest_radius;
+		header.m_peer_bandwidth = m_peer_bandwidth;
+		header.m_track_difficulty = settings.m_track_difficulty;
+
+		m_recorder.reset(new MatchRecorder());
+		if (!m_recorder->Open(settings.m_record_path, header))
+		{
+			std::cout << "Could not record the match to " << settings.m_record_path << std::endl;
+			m_recorder.reset();
+		}
+	}
+
+	if (!settings.m_statistics_path.empty())
+	{
+		m_statistics_file.open(settings.m_statistics_path, std::ios::trunc);
+		if (m_statistics_file)
+		{
+			m_statistics_file << "time,peer,round_trip_ms,jitter_ms,loss,bytes_sent_per_second,bytes_received_per_second" << std::endl;
+		}
+		else
+		{
+			std::cout << "Could not write statistics to " << settings.m_statistics_path << std::endl;
+		}
+	}
 }
 
 GameServer::~GameServer()
 {
-	m_waiting_thread_end = true;
+	m_waiting_thread_end.store(true);
+	if (m_local_wake)
+	{
+		m_local_wake->Notify();
+	}
 	m_thread.wait();
 }
 
-//This is the same as SpawnSelf but indicate that an aircraft from a different client is entering the world
+std::unique_ptr<LocalConnection> GameServer::ConnectLocal()
+{
+	std::unique_ptr<LocalConnection> client;
+	std::unique_ptr<LocalConnection> server;
+	LocalConnection::CreatePair(client, server, m_local_wake);
+
+	std::unique_ptr<LocalConnection>* slot = m_local_handoff.GetFreeSlot();
+	if (!slot)
+	{
+		//Nobody would ever answer the other end
+		client->Close();
+		return client;
+	}
+	*slot = std::move(server);
+	m_local_handoff.Push();
+	if (m_local_wake)
+	{
+		m_local_wake->Notify();
+	}
+	return client;
+}
+
+//This is the same as SpawnSelf but indicate that an aircraft from a different client is entering the world.
+//Only peers with the spawn in their area of interest are told, the rest hear of it once the bike comes near
 
 void GameServer::NotifyPlayerSpawn(sf::Int32 bike_identifier)
 {
-	sf::Packet packet;
-	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerConnect);
-	packet << bike_identifier << m_bike_info[bike_identifier].m_position.x << m_bike_info[bike_identifier].m_position.y;
-	for(std::size_t i=0; i < m_connected_players; ++i)
+	sf::Vector2f position = m_world.GetBike(bike_identifier)->m_motion.m_position;
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ServerMessage::PlayerConnect>(bike_identifier, position.x, position.y);
+
+	MessagePayload payload = Connection::MakePayload(message);
+	for (PeerPtr& peer : m_peers)
 	{
-		if(m_peers[i]->m_ready)
+		if (peer->m_ready && !OwnsBike(*peer, bike_identifier) && IsInInterest(*peer, position.x, m_interest_radius))
 		{
-			m_peers[i]->m_socket.send(packet);
+			peer->m_visible_bikes.insert(bike_identifier);
+			peer->m_connection->Send(payload, Delivery::kReliableOrdered);
 		}
 	}
 }
@@ -71,20 +231,10 @@ void GameServer::NotifyPlayerSpawn(sf::Int32 bike_identifier)
 
 void GameServer::NotifyPlayerRealtimeChange(sf::Int32 bike_identifier, sf::Int32 action, bool action_enabled)
 {
-	sf::Packet packet;
-	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerRealtimeChange);
-	packet << bike_identifier;
-	packet << action;
-	packet << action_enabled;
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ServerMessage::PlayerRealtimeChange>(bike_identifier, action, action_enabled);
 
-	for (std::size_t i = 0; i < m_connected_players; ++i)
-	{
-		if (m_peers[i]->m_ready)
-		{
-			m_peers[i]->m_socket.send(packet);
-		}
-	}
+	SendToAll(message);
 }
 
 //This takes two sf::Int32 variables, the aircraft identifier and the action identifier
@@ -93,83 +243,172 @@ void GameServer::NotifyPlayerRealtimeChange(sf::Int32 bike_identifier, sf::Int32
 
 void GameServer::NotifyPlayerEvent(sf::Int32 bike_identifier, sf::Int32 action)
 {
-	sf::Packet packet;
-	//First thing for every packet is what type of packet it is
-	packet << static_cast<sf::Int32>(Server::PacketType::PlayerEvent);
-	packet << bike_identifier;
-	packet << action;
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ServerMessage::PlayerEvent>(bike_identifier, action);
+
+	SendToAll(message);
+}
+
+//Pickups exist in the server's world as well as on the clients, so collecting one is decided here.
+//Peers are sent the pickup by UpdateInterest once it is near one of their bikes
 
-	for (std::size_t i = 0; i < m_connected_players; ++i)
+void GameServer::SpawnPickup(PickupType type, sf::Vector2f position)
+{
+	m_world.AddPickup(type, position);
+}
+
+void GameServer::SetListening(bool enable)
+{
+	//The socket stays bound for the lifetime of the server, listening only controls whether new peers are accepted.
+	//A shared host keeps accepting, its SessionManager asks each match whether it has room
+	if (m_own_host)
 	{
-		if (m_peers[i]->m_ready)
-		{
-			m_peers[i]->m_socket.send(packet);
-		}
+		m_host.SetAcceptingConnections(enable);
 	}
+	m_listening_state = enable;
 }
 
-void GameServer::SetListening(bool enable)
+
+void GameServer::ExecutionThread()
 {
-	//Check if the server listening socket is already listening
-	if (enable)
+	if (m_host.Listen(m_port))
 	{
-		if (!m_listening_state)
-		{
-			m_listening_state = (m_listener_socket.listen(SERVER_PORT) == sf::TcpListener::Done);
-		}
+		m_selector.add(m_host.GetSocket());
 	}
 	else
 	{
-		m_listener_socket.close();
-		m_listening_state = false;
+		std::cout << "Server could not bind port " << m_port << std::endl;
+	}
+	if (m_local_wake)
+	{
+		m_selector.add(m_local_wake->GetSocket());
+	}
+	SetListening(true);
+
+	while(!m_waiting_thread_end.load())
+	{
+		//Block until a socket is ready or the next tick is due, so packets are handled as soon as they arrive
+		//and an idle server does not spin. SocketSelector treats a zero timeout as infinite, so wait at least 1ms
+		sf::Time timeout = GetTimeToNextTick();
+		if (!m_local_wake && !m_local_connections.empty())
+		{
+			timeout = std::min(timeout, kLocalPollInterval);
+		}
+		bool sockets_ready = m_selector.wait(std::max(timeout, sf::milliseconds(1)));
+		if (m_local_wake)
+		{
+			m_local_wake->Clear();
+		}
+
+		if (sockets_ready)
+		{
+			m_host.Receive();
+		}
+		HandleIncomingConnections();
+		Advance();
+		CloseDroppedConnections();
+
+		//Flush everything queued this iteration as one datagram per peer, resend unacknowledged reliable messages
+		//and keep idle connections alive
+		m_host.Update();
+		for (std::unique_ptr<LocalConnection>& connection : m_local_connections)
+		{
+			connection->Flush();
+		}
 	}
 }
 
+void GameServer::Advance()
+{
+	Advance(m_advance_clock.restart());
+}
 
-void GameServer::ExecutionThread()
+void GameServer::Advance(sf::Time elapsed)
 {
-	SetListening(true);
+	if (m_recorder)
+	{
+		m_recorder->RecordAdvance(elapsed);
+	}
+	m_frame_time += elapsed;
+	m_tick_time += elapsed;
+	m_match_time += elapsed;
 
-	sf::Time frame_rate = sf::seconds(1.f / 60.f);
-	sf::Time frame_time = sf::Time::Zero;
-	sf::Time tick_rate = sf::seconds(1.f / 20.f);
-	sf::Time tick_time = sf::Time::Zero;
-	sf::Clock frame_clock, tick_clock;
+	HandleIncomingPackets();
+	UpdateStatistics(elapsed);
 
-	while(!m_waiting_thread_end)
+	//Fixed update step, caught up here rather than on its own wakeups. Input received above applies to
+	//this step, the results go out with the next Tick
+	while(m_frame_time >= kSimulationStep)
 	{
-		HandleIncomingConnections();
-		HandleIncomingPackets();
+		//The battlefield only moves once the race has started
+		if (!m_in_lobby)
+		{
+			//Scroll at the rate the clients do, they compensate by how far the battlefield has moved
+			m_world.Update(kSimulationStep, GetScrollCompensation(m_battlefield_top, m_battlefield_height));
+			m_battlefield_top += m_battlefield_scrollspeed * kSimulationStep.asSeconds();
+		}
+		m_frame_time -= kSimulationStep;
+		m_x_bounds += 3.5;
+	}
 
-		frame_time += frame_clock.getElapsedTime();
-		frame_clock.restart();
+	//Fixed tick step
+	while(m_tick_time >= m_tick_rate)
+	{
+		Tick();
+		m_tick_time -= m_tick_rate;
+	}
+}
 
-		tick_time += tick_clock.getElapsedTime();
-		tick_clock.restart();
+sf::Time GameServer::GetTimeToNextTick() const
+{
+	return m_tick_rate - (m_tick_time + m_advance_clock.getElapsedTime());
+}
 
-		//Fixed update step
-		while(frame_time >= frame_rate)
+void GameServer::CloseDroppedConnections()
+{
+	for (Connection* connection : m_dropped_connections)
+	{
+		auto local = std::find_if(m_local_connections.begin(), m_local_connections.end(), [connection](const std::unique_ptr<LocalConnection>& local_connection)
+			{
+				return local_connection.get() == connection;
+			});
+		if (local != m_local_connections.end())
 		{
-			m_battlefield_rect.top += m_battlefield_scrollspeed * frame_rate.asSeconds();
-			frame_time -= frame_rate;
-			m_x_bounds += 3.5;
+			(*local)->Close();
+			m_local_connections.erase(local);
 		}
-
-		//Fixed tick step
-		while(tick_time >= tick_rate)
+		else
 		{
-			Tick();
-			tick_time -= tick_rate;
+			m_host.Disconnect(connection);
 		}
+	}
+	m_dropped_connections.clear();
+}
 
-		//sleep
-		sf::sleep(sf::milliseconds(100));
+bool GameServer::IsAcceptingPlayers() const
+{
+	return m_listening_state;
+}
 
-	}
+bool GameServer::IsEmpty() const
+{
+	return m_connected_players == 0;
 }
 
 void GameServer::Tick()
 {
+	for (PeerPtr& peer : m_peers)
+	{
+		//A peer still joining only hears about the world through its join snapshot, interest takes over after
+		if (peer->m_ready && peer->m_joining)
+		{
+			SendJoinSnapshot(*peer);
+		}
+		else if (peer->m_ready)
+		{
+			UpdateInterest(*peer);
+		}
+	}
 	UpdateClientState();
 
 	if (!m_in_lobby)
@@ -177,104 +416,50 @@ void GameServer::Tick()
 		//Check if the game is over = all planes position.y < offset
 		bool all_bike_done = true;
 		bool only_dead_host = false;
-		for (const auto& current : m_bike_info)
+		for (const auto& current : m_world.GetBikes())
 		{
 			//As long one player has not crossed the finish line game on
 			//And the host, if is the final player, is not dead
-			if (current.second.m_position.x < 11000.0f && current.second.m_hitpoints != 22)
+			if (current.second.m_motion.m_position.x < 11000.0f && current.second.m_hitpoints != ServerWorld::kDeadHostHitpoints)
 				all_bike_done = false;
-			if(m_bike_info.size() == 1 && current.second.m_hitpoints == 22)
+			if(m_world.GetBikes().size() == 1 && current.second.m_hitpoints == ServerWorld::kDeadHostHitpoints)
 				only_dead_host = true;
 		}
 
 		if(only_dead_host)
 		{
-			sf::Packet mission_fail_packet;
-			mission_fail_packet << static_cast<sf::Int32>(Server::PacketType::MissionFail);
-			SendToAll(mission_fail_packet);
+			MessageWriter message(m_message_buffer);
+			SendToAll(message.WriteMessage<ServerMessage::MissionFail>());
 		}
 		else if (all_bike_done)
 		{
-			sf::Packet mission_success_packet;
-			mission_success_packet << static_cast<sf::Int32>(Server::PacketType::MissionSuccess);
-			SendToAll(mission_success_packet);
+			MessageWriter message(m_message_buffer);
+			SendToAll(message.WriteMessage<ServerMessage::MissionSuccess>());
 		}
 
-		//Remove aircraft that have been destroyed
-		for (auto itr = m_bike_info.begin(); itr != m_bike_info.end();)
+		//Remove bikes that have been destroyed, the snapshot just sent carried their final hitpoints
+		m_world.RemoveDestroyedBikes();
+
+		//Lay out the track ahead of the frontmost bike. Clients generate the same track themselves
+		float front = m_x_bounds;
+		for (const auto& bike : m_world.GetBikes())
 		{
-			if (itr->second.m_hitpoints <= 0)
-			{
-				m_bike_info.erase(itr++);
-			}
-			else
-			{
-				++itr;
-			}
+			front = std::max(front, bike.second.m_motion.m_position.x);
 		}
-
-		//Check if it is time to spawn obstacles and pickups
-		float x_pos = m_x_bounds;
-		//Not going to spawn enemies near the end
-		if (x_pos < 10500.0f)
+		m_track.GenerateUntil(front + kTrackLookahead, m_track_obstacles, m_track_pickups);
+		for (const TrackGenerator::ObstacleSpawn& obstacle : m_track_obstacles)
 		{
-			if (Now() >= m_time_for_next_spawn + m_last_spawn_time)
-			{
-				std::size_t obs_count = 1 + Utility::RandomInt(3);
-
-				//TODO Do we really need two packets here?
-				//Send a spawn packet to the clients
-				for (std::size_t i = 0; i < obs_count; ++i)
-				{
-					sf::Packet packet;
-					packet << static_cast<sf::Int32>(Server::PacketType::SpawnObstacle);
-					packet << static_cast<sf::Int32>(Utility::RandomInt(3));
-					packet << 650 + static_cast<float>(Utility::RandomInt(450));
-					packet << x_pos + 750 + static_cast<float>(Utility::RandomInt(350));
-
-					SendToAll(packet);
-				}
-
-				m_last_spawn_time = Now();
-				m_time_for_next_spawn = sf::milliseconds(1000 + Utility::RandomInt(5000));
-			}
-
-			if (Now() >= m_time_for_next_pickup_spawn + m_last_pickup_spawn_time)
-			{
-				std::size_t pickup_count = 1 + Utility::RandomInt(1);
-
-				//Spawn only boosts
-				for (std::size_t i = 0; i < pickup_count; ++i)
-				{
-					sf::Packet packet;
-					packet << static_cast<sf::Int32>(Server::PacketType::SpawnPickup);
-					packet << static_cast<sf::Int32>(0);
-					packet << x_pos + 750 + +static_cast<float>(Utility::RandomInt(550));
-					packet << 750 + static_cast<float>(Utility::RandomInt(200));
-
-					SendToAll(packet);
-				}
-
-				//Spawn an invincibility
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Server::PacketType::SpawnPickup);
-				packet << static_cast<sf::Int32>(1);
-				packet << x_pos + 750 + +static_cast<float>(Utility::RandomInt(750));
-				packet << 750 + static_cast<float>(Utility::RandomInt(200));
-
-				SendToAll(packet);
-
-				m_last_pickup_spawn_time = Now();
-				m_time_for_next_pickup_spawn = sf::milliseconds(2000 + Utility::RandomInt(5000));
-			}
+			m_world.AddObstacle(obstacle.m_type, obstacle.m_position, obstacle.m_index);
 		}
+		for (const TrackGenerator::PickupSpawn& pickup : m_track_pickups)
+		{
+			m_world.AddTrackPickup(pickup.m_type, pickup.m_position, pickup.m_index);
+		}
+		m_track_obstacles.clear();
+		m_track_pickups.clear();
 	}
 }
 
-sf::Time GameServer::Now() const
-{
-	return m_clock.getElapsedTime();
-}
 
 void GameServer::HandleIncomingPackets()
 {
@@ -284,18 +469,25 @@ void GameServer::HandleIncomingPackets()
 	{
 		if(peer->m_ready)
 		{
-			sf::Packet packet;
-			while(peer->m_socket.receive(packet) == sf::Socket::Done)
+			//The packet is reused, so once it has grown to the largest message receiving allocates nothing
+			sf::Packet& packet = m_receive_packet;
+			while(peer->m_connection->Receive(packet))
 			{
+				if (m_recorder)
+				{
+					m_recorder->RecordPacket(peer->m_connection, packet);
+				}
 				//Interpret the packet and react to it
 				HandleIncomingPacket(packet, *peer, detected_timeout);
-
-				peer->m_last_packet_time = Now();
-				packet.clear();
 			}
 
-			if(Now() > peer->m_last_packet_time + m_client_timeout)
+			//The client said goodbye or has gone quiet for too long
+			if(!peer->m_connection->IsConnected() || peer->m_connection->GetTimeSinceLastReceive() > m_client_timeout)
 			{
+				if (m_recorder)
+				{
+					m_recorder->RecordPeerDropped(peer->m_connection);
+				}
 				peer->m_timed_out = true;
 				detected_timeout = true;
 			}
@@ -339,65 +531,69 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 		sf::Int32 action;
 		bool action_enabled;
 		packet >> bike_identifier >> action >> action_enabled;
-		NotifyPlayerRealtimeChange(bike_identifier, action, action_enabled);
+
+		//Only relayed so other clients can animate the bike, the simulation runs from PlayerInput
+		if (OwnsBike(receiving_peer, bike_identifier))
+		{
+			NotifyPlayerRealtimeChange(bike_identifier, action, action_enabled);
+		}
 	}
 	break;
 
-	case Client::PacketType::RequestCoopPartner:
+	case Client::PacketType::PlayerInput:
 	{
-		receiving_peer.m_bike_identifiers.emplace_back(m_bike_identifier_counter);
-		m_bike_info[m_bike_identifier_counter].m_position = m_bike_info[m_bike_identifier_counter].m_position;
-		m_bike_info[m_bike_identifier_counter].m_position.x += 100;
-		m_bike_info[m_bike_identifier_counter].m_position.y -= 100;
-		m_bike_info[m_bike_identifier_counter].m_hitpoints = 100;
-		m_bike_info[m_bike_identifier_counter].m_boost = true;
-
-		sf::Packet request_packet;
-		request_packet << static_cast<sf::Int32>(Server::PacketType::AcceptCoopPartner);
-		request_packet << m_bike_identifier_counter;
-		request_packet << m_bike_info[m_bike_identifier_counter].m_position.x;
-		request_packet << m_bike_info[m_bike_identifier_counter].m_position.y;
-
-		receiving_peer.m_socket.send(request_packet);
-		m_bike_count++;
-
-		// Tell everyone else about the new plane
-		sf::Packet notify_packet;
-		notify_packet << static_cast<sf::Int32>(Server::PacketType::PlayerConnect);
-		notify_packet << m_bike_identifier_counter;
-		notify_packet << m_bike_info[m_bike_identifier_counter].m_position.x;
-		notify_packet << m_bike_info[m_bike_identifier_counter].m_position.y;
-
-		for (PeerPtr& peer : m_peers)
-		{
-			if (peer.get() != &receiving_peer && peer->m_ready)
-			{
+		sf::Int32 bike_identifier;
+		sf::Uint8 command_count;
+		packet >> bike_identifier >> command_count;
 
-				peer->m_socket.send(notify_packet);
-			}
+		//Clients only send input, and only for their own bikes
+		if (!OwnsBike(receiving_peer, bike_identifier))
+		{
+			break;
 		}
 
-		m_bike_identifier_counter++;
+		for (sf::Uint8 i = 0; i < command_count; ++i)
+		{
+			InputCommand command;
+			packet >> command.m_sequence >> command.m_input;
+			if (!packet)
+			{
+				break;
+			}
+			m_world.QueueInput(bike_identifier, command);
+		}
 	}
 	break;
 
-	case Client::PacketType::PositionUpdate:
+	case Client::PacketType::RequestCoopPartner:
 	{
-		sf::Int32 num_aircraft;
-		packet >> num_aircraft;
-
-		for (sf::Int32 i = 0; i < num_aircraft; ++i)
+		//The partner starts just ahead of the peer's first bike
+		sf::Vector2f position(m_x_bounds - 500, 650);
+		if (!receiving_peer.m_bike_identifiers.empty())
 		{
-			sf::Int32 bike_identifier;
-			sf::Int32 bike_hitpoints;
-			sf::Vector2f bike_position;
-			bool boost;
-
-			packet >> bike_identifier >> bike_position.x >> bike_position.y >> bike_hitpoints >> boost;
-			m_bike_info[bike_identifier].m_position = bike_position;
-			m_bike_info[bike_identifier].m_hitpoints = bike_hitpoints;
-			m_bike_info[bike_identifier].m_boost = boost;
+			if (const ServerWorld::BikeState* partner = m_world.GetBike(receiving_peer.m_bike_identifiers.front()))
+			{
+				position = partner->m_motion.m_position + sf::Vector2f(100.f, -100.f);
+			}
 		}
+		receiving_peer.m_bike_identifiers.emplace_back(m_bike_identifier_counter);
+		m_world.AddBike(m_bike_identifier_counter, position);
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ServerMessage::AcceptCoopPartner>(m_bike_identifier_counter, position.x, position.y);
+
+		receiving_peer.m_connection->Send(message, Delivery::kReliableOrdered);
+
+		// Tell everyone else nearby about the new plane
+		NotifyPlayerSpawn(m_bike_identifier_counter++);
+	}
+	break;
+
+	case Client::PacketType::SnapshotAck:
+	{
+		sf::Uint32 acked_snapshot;
+		packet >> acked_snapshot;
+		receiving_peer.m_acked_snapshot = std::max(receiving_peer.m_acked_snapshot, acked_snapshot);
 	}
 	break;
 
@@ -413,31 +609,50 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 
 		//Enemy explodes, with a certain probability, drop a pickup
 		//To avoid multiple messages only listen to the first peer (host)
-		if (action == GameActions::EnemyExplode && Utility::RandomInt(3) == 0 && &receiving_peer == m_peers[0].get())
+		if (action == GameActions::EnemyExplode && m_drop_random.NextInt(3) == 0 && &receiving_peer == m_peers[0].get())
 		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Server::PacketType::SpawnPickup);
-			packet << static_cast<sf::Int32>(Utility::RandomInt(static_cast<int>(PickupType::kPickupCount)));
-			packet << x;
-			packet << y;
-
-			SendToAll(packet);
+			SpawnPickup(static_cast<PickupType>(m_drop_random.NextInt(static_cast<int>(PickupType::kPickupCount))), sf::Vector2f(x, y));
 		}
 	}
 	break;
 	case Client::PacketType::PauseLobbyUpdate:
 	{
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Server::PacketType::PlayerCountUpdate);
-		packet << m_connected_players;
-		SendToAll(packet);
+		sf::Uint32 acked_snapshot;
+		packet >> acked_snapshot;
+		receiving_peer.m_acked_snapshot = std::max(receiving_peer.m_acked_snapshot, acked_snapshot);
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ServerMessage::PlayerCountUpdate>(static_cast<sf::Int32>(m_connected_players));
+		SendToAll(message);
+	}
+	break;
+	//A standalone server is a single match that already took the peer in when it connected
+	case Client::PacketType::JoinMatch:
+		break;
+
+	case Client::PacketType::Ping:
+	{
+		sf::Uint32 timestamp;
+		packet >> timestamp;
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ServerMessage::Pong>(timestamp);
+		receiving_peer.m_connection->Send(message, Delivery::kUnreliableSequenced);
+	}
+	break;
+
+	case Client::PacketType::Pong:
+	{
+		sf::Uint32 timestamp;
+		packet >> timestamp;
+		receiving_peer.m_statistics.AddRoundTrip(NetworkStatistics::SinceTimestamp(m_match_time, timestamp));
 	}
 	break;
+
 	case Client::PacketType::ClientStart:
 	{
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Server::PacketType::ServerStart);
-		SendToAll(packet);
+		MessageWriter message(m_message_buffer);
+		SendToAll(message.WriteMessage<ServerMessage::ServerStart>());
 
 		m_in_lobby = false;
 	}
@@ -447,47 +662,205 @@ void GameServer::HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_
 
 }
 
-void GameServer::HandleIncomingConnections()
+bool GameServer::OwnsBike(const RemotePeer& peer, sf::Int32 bike_identifier) const
 {
-	if(!m_listening_state)
+	return std::find(peer.m_bike_identifiers.begin(), peer.m_bike_identifiers.end(), bike_identifier) != peer.m_bike_identifiers.end();
+}
+
+//A peer is interested in whatever is within radius along the track of any of its bikes, less while its link is
+//congested. Without a bike in the world, e.g. before its first spawn, it sees everything
+bool GameServer::IsInInterest(const RemotePeer& peer, float x, float radius) const
+{
+	radius *= peer.m_send_rate.GetInterestScale();
+	bool has_bike = false;
+	for (sf::Int32 identifier : peer.m_bike_identifiers)
 	{
-		return;
+		if (const ServerWorld::BikeState* bike = m_world.GetBike(identifier))
+		{
+			has_bike = true;
+			if (std::abs(bike->m_motion.m_position.x - x) <= radius)
+			{
+				return true;
+			}
+		}
 	}
+	return !has_bike;
+}
 
-	if(m_listener_socket.accept(m_peers[m_connected_players]->m_socket) == sf::TcpListener::Done)
+//Tells the peer about bikes entering or leaving its area of interest and sends it obstacles and pickups that came near
+void GameServer::UpdateInterest(RemotePeer& peer)
+{
+	for (const auto& bike : m_world.GetBikes())
 	{
-		//Order the new client to spawn its player 1
-		m_bike_info[m_bike_identifier_counter].m_position = sf::Vector2f(m_x_bounds - 500, 650);
-		m_bike_info[m_bike_identifier_counter].m_hitpoints = 100;
-		m_bike_info[m_bike_identifier_counter].m_boost = true;
+		if (OwnsBike(peer, bike.first))
+		{
+			continue;
+		}
 
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Server::PacketType::SpawnSelf);
-		packet << m_bike_identifier_counter;
-		packet << m_bike_info[m_bike_identifier_counter].m_position.x;
-		packet << m_bike_info[m_bike_identifier_counter].m_position.y;
+		//Bikes have to get a bit further away to leave than to enter, so one hovering at the edge does not flicker
+		bool visible = peer.m_visible_bikes.count(bike.first) != 0;
+		float radius = visible ? m_interest_radius * kInterestHysteresis : m_interest_radius;
+		bool interested = IsInInterest(peer, bike.second.m_motion.m_position.x, radius);
 
-		m_peers[m_connected_players]->m_bike_identifiers.emplace_back(m_bike_identifier_counter);
+		if (interested && !visible)
+		{
+			peer.m_visible_bikes.insert(bike.first);
 
-		BroadcastMessage("New player");
-		InformWorldState(m_peers[m_connected_players]->m_socket);
-		NotifyPlayerSpawn(m_bike_identifier_counter++);
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ServerMessage::BikeEnterInterest>(bike.first, bike.second.m_motion.m_position.x, bike.second.m_motion.m_position.y);
+			peer.m_connection->Send(message, Delivery::kReliableOrdered);
+		}
+		else if (!interested && visible)
+		{
+			peer.m_visible_bikes.erase(bike.first);
 
-		m_peers[m_connected_players]->m_socket.send(packet);
-		m_peers[m_connected_players]->m_ready = true;
-		m_peers[m_connected_players]->m_last_packet_time = Now();
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ServerMessage::BikeLeaveInterest>(bike.first);
+			peer.m_connection->Send(message, Delivery::kReliableOrdered);
+		}
+	}
 
-		m_bike_count++;
-		m_connected_players++;
+	//Forget bikes that were destroyed or disconnected, clients learn of those from the snapshot or PlayerDisconnect
+	for (auto itr = peer.m_visible_bikes.begin(); itr != peer.m_visible_bikes.end();)
+	{
+		itr = m_world.GetBike(*itr) ? std::next(itr) : peer.m_visible_bikes.erase(itr);
+	}
 
-		if(m_connected_players >= m_max_connected_players)
+	//Clients generate the track's obstacles and pickups themselves, only dropped pickups are sent. They stay put and
+	//clients remove their own copies, so each only needs sending once. Pickups and the set are both in identifier
+	//order, so identifiers the world no longer has are erased in place as they are passed and the set does not grow
+	//over the race
+	auto known = peer.m_known_entities.begin();
+	for (const ServerWorld::PickupState& pickup : m_world.GetPickups())
+	{
+		while (known != peer.m_known_entities.end() && *known < pickup.m_identifier)
 		{
-			SetListening(false);
+			known = peer.m_known_entities.erase(known);
 		}
-		else
+		if (known != peer.m_known_entities.end() && *known == pickup.m_identifier)
+		{
+			++known;
+			continue;
+		}
+
+		if (!pickup.m_on_track && IsInInterest(peer, pickup.m_position.x, m_interest_radius))
+		{
+			peer.m_known_entities.insert(known, pickup.m_identifier);
+
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ServerMessage::SpawnPickup>(static_cast<sf::Int32>(pickup.m_type), pickup.m_position.x, pickup.m_position.y);
+			peer.m_connection->Send(message, Delivery::kReliableOrdered);
+		}
+	}
+	peer.m_known_entities.erase(known, peer.m_known_entities.end());
+}
+
+//Pings every peer on the match clock, so a replayed match sends the same Pings, and writes the figures out
+
+void GameServer::UpdateStatistics(sf::Time elapsed)
+{
+	m_since_ping += elapsed;
+	bool send_ping = m_since_ping >= NetworkStatistics::kPingInterval;
+	if (send_ping)
+	{
+		m_since_ping = sf::Time::Zero;
+	}
+
+	m_since_statistics_write += elapsed;
+	bool write_statistics = m_statistics_file.is_open() && m_since_statistics_write >= kStatisticsWriteInterval;
+	if (write_statistics)
+	{
+		m_since_statistics_write = sf::Time::Zero;
+	}
+
+	for (PeerPtr& peer : m_peers)
+	{
+		if (!peer->m_ready)
 		{
-			m_peers.emplace_back(PeerPtr(new RemotePeer()));
+			continue;
 		}
+
+		NetworkStatistics& statistics = peer->m_statistics;
+		statistics.Update(peer->m_connection->GetTraffic(), elapsed);
+		peer->m_send_rate.Update(statistics, elapsed);
+		if (send_ping)
+		{
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ServerMessage::Ping>(NetworkStatistics::ToTimestamp(m_match_time));
+			peer->m_connection->Send(message, Delivery::kUnreliableSequenced);
+		}
+		if (write_statistics)
+		{
+			m_statistics_file << m_match_time.asSeconds() << "," << peer->m_identifier << ","
+				<< statistics.GetRoundTripTime().asMilliseconds() << "," << statistics.GetJitter().asMilliseconds() << ","
+				<< statistics.GetLoss() << "," << statistics.GetBytesSentPerSecond() << "," << statistics.GetBytesReceivedPerSecond() << "\n";
+		}
+	}
+
+	if (write_statistics)
+	{
+		m_statistics_file.flush();
+	}
+}
+
+void GameServer::HandleIncomingConnections()
+{
+	if(!m_listening_state)
+	{
+		return;
+	}
+
+	UdpConnection* connection;
+	while(m_listening_state && (connection = m_host.Accept()) != nullptr)
+	{
+		AddPeer(connection);
+	}
+
+	std::unique_ptr<LocalConnection>* local_connection;
+	while(m_listening_state && (local_connection = m_local_handoff.GetFront()) != nullptr)
+	{
+		m_local_connections.push_back(std::move(*local_connection));
+		m_local_handoff.Pop();
+		AddPeer(m_local_connections.back().get());
+	}
+}
+
+void GameServer::AddPeer(Connection* connection)
+{
+	if (m_recorder)
+	{
+		m_recorder->RecordPeerConnected(connection);
+	}
+	m_peers[m_connected_players]->m_connection = connection;
+	m_peers[m_connected_players]->m_identifier = m_peer_counter++;
+	m_peers[m_connected_players]->m_send_rate = SendRateController(kMaxSnapshotInterval, m_peer_bandwidth);
+
+	//Order the new client to spawn its player 1
+	sf::Int32 bike_identifier = m_bike_identifier_counter;
+	sf::Vector2f position = m_world.AddBike(bike_identifier, sf::Vector2f(m_x_bounds - 500, 650)).m_motion.m_position;
+
+	m_peers[m_connected_players]->m_bike_identifiers.emplace_back(bike_identifier);
+	m_peers[m_connected_players]->m_snapshot_history.Reserve(m_max_connected_players);
+
+	BroadcastMessage("New player");
+	InformWorldState(*m_peers[m_connected_players]);
+	NotifyPlayerSpawn(m_bike_identifier_counter++);
+
+	//Written last, the messages above share the same buffer
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ServerMessage::SpawnSelf>(bike_identifier, position.x, position.y);
+	connection->Send(message, Delivery::kReliableOrdered);
+	m_peers[m_connected_players]->m_ready = true;
+
+	m_connected_players++;
+
+	if(m_connected_players >= m_max_connected_players)
+	{
+		SetListening(false);
+	}
+	else
+	{
+		m_peers.emplace_back(PeerPtr(new RemotePeer()));
 	}
 }
 
@@ -500,12 +873,13 @@ void GameServer::HandleDisconnections()
 			//Inform everyone of a disconnection, erase
 			for(sf::Int32 identifer : (*itr)->m_bike_identifiers)
 			{
-				SendToAll((sf::Packet() << static_cast<sf::Int32>(Server::PacketType::PlayerDisconnect) << identifer));
-				m_bike_info.erase(identifer);
+				MessageWriter message(m_message_buffer);
+				SendToAll(message.WriteMessage<ServerMessage::PlayerDisconnect>(identifer));
+				m_world.RemoveBike(identifer);
 			}
 
 			m_connected_players--;
-			m_bike_count -= (*itr)->m_bike_identifiers.size();
+			m_dropped_connections.push_back((*itr)->m_connection);
 
 			itr = m_peers.erase(itr);
 
@@ -528,63 +902,225 @@ void GameServer::HandleDisconnections()
 	
 }
 
-void GameServer::InformWorldState(sf::TcpSocket& socket)
-{
-	sf::Packet packet;
-	packet << static_cast<sf::Int32>(Server::PacketType::InitialState);
-	packet << m_world_width << m_battlefield_rect.height;
-	packet << static_cast<sf::Int32>(m_bike_count);
+//The new peer is told how to lay out the track and where the race has got to, the rest of the world follows in
+//its join snapshot over the next ticks. It starts out with the other bikes near its own, its own bike follows in SpawnSelf
 
-	for(std::size_t i=0; i < m_connected_players; ++i)
+void GameServer::InformWorldState(RemotePeer& peer)
+{
+	for(const auto& bike : m_world.GetBikes())
 	{
-		if(m_peers[i]->m_ready)
+		if (!OwnsBike(peer, bike.first) && IsInInterest(peer, bike.second.m_motion.m_position.x, m_interest_radius))
 		{
-			for(sf::Int32 identifier : m_peers[i]->m_bike_identifiers)
-			{
-				packet << identifier << m_bike_info[identifier].m_position.x << m_bike_info[identifier].m_position.y << m_bike_info[identifier].m_hitpoints << m_bike_info[identifier].m_boost;
-			}
+			peer.m_visible_bikes.insert(bike.first);
 		}
 	}
 
-	socket.send(packet);
+	peer.m_joining = true;
+	peer.m_join_section = Server::JoinSnapshotSection::kBikes;
+	peer.m_join_cursor = 0;
+
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ServerMessage::InitialState>(m_world_width, m_battlefield_height, m_track.GetSettings().m_seed, m_track.GetSettings().m_difficulty, m_world.GetViewLeft());
+	peer.m_connection->Send(message, Delivery::kReliableOrdered);
 }
 
-void GameServer::BroadcastMessage(const std::string& message)
+//A busy match can have more to tell a late joiner than fits in a tick, so the join snapshot goes out a bounded number
+//of entries per tick. Every chunk is read from the world as it is then, carrying on from where the last one stopped,
+//so whatever changes in between is either in a later chunk or reaches the peer the way it reaches everyone else.
+//Track entities are sent as the indices of the ones still there; the client generates the track and leaves out the rest
+
+void GameServer::SendJoinSnapshot(RemotePeer& peer)
 {
-	sf::Packet packet;
-	packet << static_cast<sf::Int32>(Server::PacketType::BroadcastMessage);
-	packet << message;
-	for(std::size_t i=0; i < m_connected_players; ++i)
+	std::size_t budget = kJoinSnapshotEntries;
+	while (peer.m_joining && budget > 0)
 	{
-		if(m_peers[i]->m_ready)
+		const sf::Uint32 cursor = peer.m_join_cursor;
+		std::size_t count = 0;
+		bool last = false;
+		MessageWriter message(m_message_buffer);
+
+		switch (peer.m_join_section)
+		{
+		case Server::JoinSnapshotSection::kBikes:
+		{
+			auto has_bike = [this](sf::Int32 identifier) { return m_world.GetBike(identifier) != nullptr; };
+			auto first = peer.m_visible_bikes.lower_bound(static_cast<sf::Int32>(cursor));
+			auto end = FindChunkEnd(first, peer.m_visible_bikes.end(), budget, has_bike, count);
+			last = end == peer.m_visible_bikes.end();
+
+			message.WriteMessage<ServerMessage::JoinSnapshot>(static_cast<sf::Uint8>(peer.m_join_section), static_cast<sf::Uint16>(count), last);
+			for (auto itr = first; itr != end; ++itr)
+			{
+				if (const ServerWorld::BikeState* bike = m_world.GetBike(*itr))
+				{
+					BikeSnapshot state = m_snapshot_codec.Capture(bike->m_motion, bike->m_hitpoints, bike->m_invincible, bike->m_last_input);
+					message << *itr << state.m_x << state.m_y << state.m_hitpoints << state.m_boost;
+				}
+			}
+			peer.m_join_cursor = last ? 0 : static_cast<sf::Uint32>(*end);
+		}
+		break;
+
+		case Server::JoinSnapshotSection::kDroppedPickups:
 		{
-			m_peers[i]->m_socket.send(packet);
+			//Only those near the peer's bikes, the same as UpdateInterest sends
+			auto is_wanted = [this, &peer, cursor](const ServerWorld::PickupState& pickup)
+			{
+				return !pickup.m_on_track && pickup.m_identifier >= cursor && IsInInterest(peer, pickup.m_position.x, m_interest_radius);
+			};
+			const std::vector<ServerWorld::PickupState>& pickups = m_world.GetPickups();
+			auto end = FindChunkEnd(pickups.begin(), pickups.end(), budget, is_wanted, count);
+			last = end == pickups.end();
+
+			message.WriteMessage<ServerMessage::JoinSnapshot>(static_cast<sf::Uint8>(peer.m_join_section), static_cast<sf::Uint16>(count), last);
+			for (auto itr = pickups.begin(); itr != end; ++itr)
+			{
+				if (is_wanted(*itr))
+				{
+					message << static_cast<sf::Uint8>(itr->m_type) << itr->m_position.x << itr->m_position.y;
+					peer.m_known_entities.insert(itr->m_identifier);
+				}
+			}
+			peer.m_join_cursor = last ? 0 : end->m_identifier;
+		}
+		break;
+
+		case Server::JoinSnapshotSection::kTrackObstacles:
+		{
+			auto is_unsent = [cursor](const ServerWorld::ObstacleState& obstacle) { return obstacle.m_track_index >= cursor; };
+			const std::vector<ServerWorld::ObstacleState>& obstacles = m_world.GetObstacles();
+			auto end = FindChunkEnd(obstacles.begin(), obstacles.end(), budget, is_unsent, count);
+			last = end == obstacles.end();
+
+			message.WriteMessage<ServerMessage::JoinSnapshot>(static_cast<sf::Uint8>(peer.m_join_section), static_cast<sf::Uint16>(count), last);
+			for (auto itr = obstacles.begin(); itr != end; ++itr)
+			{
+				if (is_unsent(*itr))
+				{
+					message << static_cast<sf::Uint16>(itr->m_track_index - peer.m_join_cursor);
+					peer.m_join_cursor = itr->m_track_index + 1;
+				}
+			}
+			//Everything generated before now that was not listed has been used up
+			if (last)
+			{
+				message << m_track.GetObstacleCount();
+				peer.m_join_cursor = 0;
+			}
+		}
+		break;
+
+		case Server::JoinSnapshotSection::kTrackPickups:
+		{
+			auto is_unsent = [cursor](const ServerWorld::PickupState& pickup) { return pickup.m_on_track && pickup.m_track_index >= cursor; };
+			const std::vector<ServerWorld::PickupState>& pickups = m_world.GetPickups();
+			auto end = FindChunkEnd(pickups.begin(), pickups.end(), budget, is_unsent, count);
+			last = end == pickups.end();
+
+			message.WriteMessage<ServerMessage::JoinSnapshot>(static_cast<sf::Uint8>(peer.m_join_section), static_cast<sf::Uint16>(count), last);
+			for (auto itr = pickups.begin(); itr != end; ++itr)
+			{
+				if (is_unsent(*itr))
+				{
+					message << static_cast<sf::Uint16>(itr->m_track_index - peer.m_join_cursor);
+					peer.m_join_cursor = itr->m_track_index + 1;
+				}
+			}
+			if (last)
+			{
+				message << m_track.GetPickupCount();
+				peer.m_join_cursor = 0;
+			}
+		}
+		break;
+		}
+
+		peer.m_connection->Send(message, Delivery::kReliableOrdered);
+		peer.m_send_rate.OnSent(message.GetSize());
+		budget -= count;
+
+		if (last && peer.m_join_section == Server::JoinSnapshotSection::kTrackPickups)
+		{
+			peer.m_joining = false;
+		}
+		else if (last)
+		{
+			peer.m_join_section = static_cast<Server::JoinSnapshotSection>(static_cast<int>(peer.m_join_section) + 1);
 		}
 	}
 }
 
-void GameServer::SendToAll(sf::Packet& packet)
+void GameServer::BroadcastMessage(const std::string& message)
+{
+	MessageWriter writer(m_message_buffer);
+	writer.WriteMessage<ServerMessage::BroadcastMessage>(message);
+
+	SendToAll(writer);
+}
+
+void GameServer::SendToAll(const MessageWriter& message, Delivery delivery)
 {
+	//Serialize once, every peer's queue shares the same bytes
+	MessagePayload payload = Connection::MakePayload(message);
 	for(PeerPtr& peer : m_peers)
 	{
 		if(peer->m_ready)
 		{
-			peer->m_socket.send(packet);
+			peer->m_connection->Send(payload, delivery);
 		}
 	}
 }
 
 void GameServer::UpdateClientState()
 {
-	sf::Packet update_client_state_packet;
-	update_client_state_packet << static_cast<sf::Int32>(Server::PacketType::UpdateClientState);
-	update_client_state_packet << static_cast<float>(m_battlefield_rect.top + m_battlefield_rect.height);
-	update_client_state_packet << static_cast<sf::Int32>(m_bike_count);
-
-	for(const auto& bike : m_bike_info)
+	//The match's snapshot and every peer's are refilled in place, so once their storage has grown to fit the bikes
+	//nothing here allocates
+	WorldSnapshot& snapshot = m_snapshot;
+	snapshot.m_sequence = ++m_snapshot_sequence;
+	snapshot.m_tick = m_world.GetTick();
+	snapshot.m_world_position = m_battlefield_top + m_battlefield_height;
+	snapshot.m_bikes.clear();
+	//The world's bikes are in identifier order already
+	for(const auto& bike : m_world.GetBikes())
 	{
-		update_client_state_packet << bike.first << bike.second.m_position.x << bike.second.m_position.y << bike.second.m_hitpoints << bike.second.m_boost;
+		snapshot.m_bikes.emplace_back(bike.first, m_snapshot_codec.Capture(bike.second.m_motion, bike.second.m_hitpoints, bike.second.m_invincible, bike.second.m_last_input));
 	}
 
-	SendToAll(update_client_state_packet);
+	//Each peer gets its own bikes and those in its area of interest, as a delta against the last snapshot it acknowledged.
+	//A peer whose link cannot keep up skips ticks, its next snapshot deltas against what it did receive
+	for(PeerPtr& peer : m_peers)
+	{
+		if(!peer->m_ready || !peer->m_send_rate.ShouldSend(m_tick_rate))
+		{
+			continue;
+		}
+
+		//Only use baselines the client is guaranteed to still have in its own history
+		const WorldSnapshot* baseline = nullptr;
+		if(snapshot.m_sequence - peer->m_acked_snapshot < SnapshotHistory::kSize)
+		{
+			baseline = peer->m_snapshot_history.Find(peer->m_acked_snapshot);
+		}
+
+		//Built straight into the history slot it is kept in. That is never the baseline's, which is less than kSize older
+		WorldSnapshot& peer_snapshot = peer->m_snapshot_history.Begin(snapshot.m_sequence);
+		peer_snapshot.m_tick = snapshot.m_tick;
+		peer_snapshot.m_world_position = snapshot.m_world_position;
+		for(const auto& bike : snapshot.m_bikes)
+		{
+			if(OwnsBike(*peer, bike.first) || peer->m_visible_bikes.count(bike.first) != 0)
+			{
+				peer_snapshot.m_bikes.emplace_back(bike);
+			}
+		}
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ServerMessage::UpdateClientState>();
+		m_snapshot_codec.WriteDelta(message, baseline, peer_snapshot);
+
+		//Snapshots are superseded every tick, so a lost one is never resent. The connection copies the bytes
+		//into its own reused buffer
+		peer->m_connection->Send(message, Delivery::kUnreliableSequenced);
+		peer->m_send_rate.OnSent(message.GetSize());
+	}
 }
@@ -1,21 +1,77 @@
 #pragma once
+#include <atomic>
+#include <fstream>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <SFML/Config.hpp>
-#include <SFML/Graphics/Rect.hpp>
 #include <SFML/System/Vector2.hpp>
-#include <SFML/Network/TcpSocket.hpp>
-#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/Network/SocketSelector.hpp>
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Thread.hpp>
 
+#include "LocalConnection.hpp"
+#include "MatchRecording.hpp"
+#include "MessageWriter.hpp"
+#include "NetworkProtocol.hpp"
+#include "NetworkStatistics.hpp"
+#include "RandomStream.hpp"
+#include "SendRateController.hpp"
+#include "SpscQueue.hpp"
+#include "TrackGenerator.hpp"
+#include "ServerWorld.hpp"
+#include "Snapshot.hpp"
+#include "UdpHost.hpp"
+
+//Everything a dedicated server can be configured with from the command line
+struct ServerSettings
+{
+	ServerSettings();
+	unsigned short m_port;
+	std::size_t m_max_connected_players;
+	sf::Time m_tick_rate;
+	float m_simulated_loss;
+	//Bikes, obstacles and pickups further along the track than this from all of a peer's bikes are not sent to it
+	float m_interest_radius;
+	//Bytes per second of snapshots each peer may be sent, 0 for no limit. Congested peers get less either way
+	float m_peer_bandwidth;
+	//Scales how many obstacles the generated track has, 1 is the standard race
+	float m_track_difficulty;
+	//The match's random streams are split off this, 0 picks one from the clock
+	sf::Uint32 m_random_seed;
+	//When set, everything the match receives is recorded to this file so MatchReplay can run it again
+	std::string m_record_path;
+	//When set, every peer's round trip, jitter, loss and bandwidth are written to this file once a second
+	std::string m_statistics_path;
+};
+
+//The server only depends on sfml-system and sfml-network so that it can also be built as a headless dedicated server.
+//Standalone it runs one match on its own thread and socket. A dedicated server's SessionManager instead hosts many
+//matches on one shared UdpHost: it hands them their peers and calls Advance, and only its own thread touches the socket
 class GameServer
 {
 public:
-	explicit GameServer(sf::Vector2f battlefield_size);
+	explicit GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings = ServerSettings());
+	GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings, UdpHost& shared_host);
 	~GameServer();
+	//Connects the host's own client to a standalone server without going through the socket. The server's thread
+	//picks the other end up the next time it checks for connections. Only ever called from the host's one thread
+	std::unique_ptr<LocalConnection> ConnectLocal();
 	void NotifyPlayerSpawn(sf::Int32 bike_identifier);
+
+	//Used by a SessionManager hosting this match
+	bool IsAcceptingPlayers() const;
+	bool IsEmpty() const;
+	void AddPeer(Connection* connection);
+	//Handles received packets and runs the fixed steps and ticks that are due. Touches only this match's connections
+	void Advance();
+	//The same for a given amount of time rather than what the clock says, used to replay a recording
+	void Advance(sf::Time elapsed);
+	sf::Time GetTimeToNextTick() const;
+	//Disconnects peers that left or timed out during Advance, must run where the host's socket may be used
+	void CloseDroppedConnections();
 	void NotifyPlayerRealtimeChange(sf::Int32 bike_identifier, sf::Int32 action, bool action_enabled);
 	void NotifyPlayerEvent(sf::Int32 bike_identifier, sf::Int32 action);
 
@@ -23,68 +79,115 @@ private:
 	struct RemotePeer
 	{
 		RemotePeer();
-		sf::TcpSocket m_socket;
-		sf::Time m_last_packet_time;
+		Connection* m_connection;
+		//Numbered in the order peers joined the match, for the statistics file
+		sf::Uint32 m_identifier;
+		NetworkStatistics m_statistics;
+		//Which ticks this peer is sent a snapshot on, and how far its area of interest reaches
+		SendRateController m_send_rate;
 		std::vector<sf::Int32> m_bike_identifiers;
+		sf::Uint32 m_acked_snapshot;
+		//Snapshots as this peer was sent them, with only the bikes in its area of interest
+		SnapshotHistory m_snapshot_history;
+		//Other peers' bikes this peer has been told about, and dropped pickups it has been sent
+		std::set<sf::Int32> m_visible_bikes;
+		std::set<sf::Uint32> m_known_entities;
+		//How far streaming the join snapshot has got: the section, and the bike or entity identifier or track index
+		//the next chunk carries on from
+		bool m_joining;
+		Server::JoinSnapshotSection m_join_section;
+		sf::Uint32 m_join_cursor;
 		bool m_ready;
 		bool m_timed_out;
 	};
 
-	struct BikeInfo
-	{
-		sf::Vector2f m_position;
-		sf::Int32 m_hitpoints;
-		bool m_boost;
-		//bool m_color_id;
-		std::map<sf::Int32, bool> m_realtime_actions;
-	};
-
 	typedef std::unique_ptr<RemotePeer> PeerPtr;
 
 private:
+	GameServer(sf::Vector2f battlefield_size, const ServerSettings& settings, UdpHost* shared_host);
 	void SetListening(bool enable);
 	void ExecutionThread();
 	void Tick();
-	sf::Time Now() const;
 
 	void HandleIncomingPackets();
 	void HandleIncomingPacket(sf::Packet& packet, RemotePeer& receiving_peer, bool& detected_timeout);
+	bool OwnsBike(const RemotePeer& peer, sf::Int32 bike_identifier) const;
+	bool IsInInterest(const RemotePeer& peer, float x, float radius) const;
+	void UpdateInterest(RemotePeer& peer);
+	void UpdateStatistics(sf::Time elapsed);
 
 	void HandleIncomingConnections();
 	void HandleDisconnections();
 
-	void InformWorldState(sf::TcpSocket& socket);
+	void InformWorldState(RemotePeer& peer);
+	void SendJoinSnapshot(RemotePeer& peer);
 	void BroadcastMessage(const std::string& message);
-	void SendToAll(sf::Packet& packet);
+	void SendToAll(const MessageWriter& message, Delivery delivery = Delivery::kReliableOrdered);
+	void SpawnPickup(PickupType type, sf::Vector2f position);
 	void UpdateClientState();
 
 private:
 	sf::Thread m_thread;
-	sf::Clock m_clock;
-	sf::TcpListener m_listener_socket;
+	//Only set for a standalone server, a hosted match uses its SessionManager's host
+	std::unique_ptr<UdpHost> m_own_host;
+	UdpHost& m_host;
+	std::vector<Connection*> m_dropped_connections;
+	//Server ends of in-process connections, handed over from the host's thread through the queue
+	SpscQueue<std::unique_ptr<LocalConnection>> m_local_handoff;
+	std::vector<std::unique_ptr<LocalConnection>> m_local_connections;
+	//Wakes the server's thread when the host's client sends. Only a standalone server has one, and only if it could bind
+	std::shared_ptr<WakeSignal> m_local_wake;
+	sf::SocketSelector m_selector;
+	unsigned short m_port;
 	bool m_listening_state;
 	sf::Time m_client_timeout;
+	sf::Time m_tick_rate;
+	float m_interest_radius;
+	float m_peer_bandwidth;
+	sf::Time m_frame_time;
+	sf::Time m_tick_time;
+	//Time only moves on in Advance, so a replayed match sees the same times as the recorded one
+	sf::Clock m_advance_clock;
+	sf::Time m_match_time;
+	std::unique_ptr<MatchRecorder> m_recorder;
+	std::ofstream m_statistics_file;
+	sf::Time m_since_ping;
+	sf::Time m_since_statistics_write;
+	sf::Uint32 m_peer_counter;
 
 	std::size_t m_max_connected_players;
 	std::size_t m_connected_players;
 
 	float m_world_width;
-	sf::FloatRect m_battlefield_rect;
+	float m_battlefield_top;
+	float m_battlefield_height;
 	float m_battlefield_scrollspeed;
 
-	std::size_t m_bike_count;
-	std::map<sf::Int32, BikeInfo> m_bike_info;
+	//Authoritative state of every bike, obstacle and pickup, stepped with the fixed update
+	ServerWorld m_world;
 
 	std::vector<PeerPtr> m_peers;
 	sf::Int32 m_bike_identifier_counter;
 	float m_x_bounds;
-	bool m_waiting_thread_end;
-
-	sf::Time m_last_spawn_time;
-	sf::Time m_last_pickup_spawn_time;
-	sf::Time m_time_for_next_spawn;
-	sf::Time m_time_for_next_pickup_spawn;
+	//Set by the destructor on another thread
+	std::atomic<bool> m_waiting_thread_end;
 
 	bool m_in_lobby;
+	//The track is generated from the match seed, on the clients as well. Pickups dropped by explosions depend on
+	//when those are reported, so they have a stream of their own
+	sf::Uint32 m_random_seed;
+	RandomStream m_drop_random;
+	TrackGenerator m_track;
+	std::vector<TrackGenerator::ObstacleSpawn> m_track_obstacles;
+	std::vector<TrackGenerator::PickupSpawn> m_track_pickups;
+
+	SnapshotCodec m_snapshot_codec;
+	sf::Uint32 m_snapshot_sequence;
+	//Every bike in the match, captured once a tick and filtered into each peer's snapshot
+	WorldSnapshot m_snapshot;
+
+	//Every message is written into this and every received one read from that, both only ever grow
+	std::vector<char> m_message_buffer;
+	sf::Packet m_receive_packet;
 };
 
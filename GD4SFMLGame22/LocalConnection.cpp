@@ -0,0 +1,134 @@
+#include "LocalConnection.hpp"
+
+namespace
+{
+	//Messages each way. A frame's inputs or a tick's snapshot and events are a handful
+	const std::size_t kChannelCapacity = 1024;
+}
+
+LocalConnection::Channel::Channel()
+	: m_messages(kChannelCapacity)
+	, m_last_push(0)
+{
+}
+
+LocalConnection::Link::Link()
+	: m_closed(false)
+{
+}
+
+void LocalConnection::CreatePair(std::unique_ptr<LocalConnection>& client, std::unique_ptr<LocalConnection>& server, const std::shared_ptr<WakeSignal>& server_wake)
+{
+	std::shared_ptr<Link> link = std::make_shared<Link>();
+	link->m_to_server.m_wake = server_wake;
+	client.reset(new LocalConnection(link, link->m_to_server, link->m_to_client));
+	server.reset(new LocalConnection(link, link->m_to_client, link->m_to_server));
+}
+
+LocalConnection::LocalConnection(const std::shared_ptr<Link>& link, Channel& outgoing, Channel& incoming)
+	: m_link(link)
+	, m_outgoing(outgoing)
+	, m_incoming(incoming)
+{
+}
+
+void LocalConnection::Send(const MessagePayload& payload, Delivery delivery)
+{
+	Send(payload->data(), payload->size(), delivery);
+}
+
+void LocalConnection::Send(const char* data, std::size_t size, Delivery delivery)
+{
+	if (!IsConnected())
+	{
+		return;
+	}
+
+	++m_traffic.m_datagrams_sent;
+	m_traffic.m_bytes_sent += size;
+
+	//Reliable messages stay in order behind any that are already waiting
+	if (delivery == Delivery::kReliableOrdered && !m_overflow.empty())
+	{
+		m_overflow.emplace_back(data, data + size);
+	}
+	else if (TryPush(data, size))
+	{
+		++m_traffic.m_datagrams_acked;
+	}
+	else if (delivery == Delivery::kReliableOrdered)
+	{
+		m_overflow.emplace_back(data, data + size);
+	}
+	else
+	{
+		++m_traffic.m_datagrams_lost;
+	}
+}
+
+void LocalConnection::Flush()
+{
+	while (!m_overflow.empty() && TryPush(m_overflow.front().data(), m_overflow.front().size()))
+	{
+		++m_traffic.m_datagrams_acked;
+		m_overflow.pop_front();
+	}
+}
+
+bool LocalConnection::Receive(sf::Packet& packet)
+{
+	std::vector<char>* message = m_incoming.m_messages.GetFront();
+	if (!message)
+	{
+		return false;
+	}
+
+	packet.clear();
+	packet.append(message->data(), message->size());
+	m_traffic.m_bytes_received += message->size();
+	m_incoming.m_messages.Pop();
+	return true;
+}
+
+bool LocalConnection::IsConnected() const
+{
+	return !m_link->m_closed.load();
+}
+
+sf::Time LocalConnection::GetTimeSinceLastReceive() const
+{
+	return m_link->m_clock.getElapsedTime() - sf::microseconds(m_incoming.m_last_push.load());
+}
+
+const ConnectionTraffic& LocalConnection::GetTraffic() const
+{
+	return m_traffic;
+}
+
+void LocalConnection::Close()
+{
+	m_link->m_closed.store(true);
+	if (m_outgoing.m_wake)
+	{
+		m_outgoing.m_wake->Notify();
+	}
+}
+
+bool LocalConnection::TryPush(const char* data, std::size_t size)
+{
+	std::vector<char>* slot = m_outgoing.m_messages.GetFreeSlot();
+	if (!slot)
+	{
+		return false;
+	}
+
+	//The slot keeps its capacity from the last message through it
+	slot->assign(data, data + size);
+	m_outgoing.m_messages.Push();
+	m_outgoing.m_last_push.store(m_link->m_clock.getElapsedTime().asMicroseconds());
+	if (m_outgoing.m_wake)
+	{
+		m_outgoing.m_wake->Notify();
+	}
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include "Connection.hpp"
+#include "SpscQueue.hpp"
+#include "WakeSignal.hpp"
+
+//One end of a connection between two threads of the same process, the host's own client and the GameServer it
+//runs. Messages go through a lock-free ring buffer each way instead of the socket, so nothing is resent,
+//acknowledged or copied through the kernel. Each end must only be used from one thread
+class LocalConnection : public Connection, private sf::NonCopyable
+{
+public:
+	//The server's wake signal, if given, is notified whenever the client end sends or closes, so a server blocked
+	//waiting on its sockets picks the message up straight away
+	static void CreatePair(std::unique_ptr<LocalConnection>& client, std::unique_ptr<LocalConnection>& server, const std::shared_ptr<WakeSignal>& server_wake = nullptr);
+
+	using Connection::Send;
+	void Send(const MessagePayload& payload, Delivery delivery) override;
+	//Goes straight into the ring buffer. A reliable message that does not fit waits for Flush, an unreliable one is dropped
+	void Send(const char* data, std::size_t size, Delivery delivery) override;
+	void Flush() override;
+	bool Receive(sf::Packet& packet) override;
+	bool IsConnected() const override;
+	sf::Time GetTimeSinceLastReceive() const override;
+	const ConnectionTraffic& GetTraffic() const override;
+
+	//Either end closing disconnects both
+	void Close();
+
+private:
+	//Messages one way, and when the last one went in on the link's clock in microseconds. The receiving end's
+	//wake signal, if it blocks waiting for messages
+	struct Channel
+	{
+		Channel();
+		SpscQueue<std::vector<char>> m_messages;
+		std::atomic<sf::Int64> m_last_push;
+		std::shared_ptr<WakeSignal> m_wake;
+	};
+
+	struct Link
+	{
+		Link();
+		sf::Clock m_clock;
+		Channel m_to_server;
+		Channel m_to_client;
+		std::atomic<bool> m_closed;
+	};
+
+private:
+	LocalConnection(const std::shared_ptr<Link>& link, Channel& outgoing, Channel& incoming);
+	bool TryPush(const char* data, std::size_t size);
+
+private:
+	std::shared_ptr<Link> m_link;
+	Channel& m_outgoing;
+	Channel& m_incoming;
+	//Reliable messages that found the ring buffer full, in order
+	std::deque<std::vector<char>> m_overflow;
+	ConnectionTraffic m_traffic;
+};
@@ -0,0 +1,191 @@
+#include "MatchRecording.hpp"
+
+#include "Connection.hpp"
+
+namespace
+{
+	const sf::Uint32 kRecordingMagic = 0x4D525243;
+	const sf::Uint32 kRecordingVersion = 3;
+	//Nothing the server receives comes close, a larger length means the file is corrupt
+	const sf::Uint32 kMaxRecordSize = 1 << 20;
+}
+
+//Every record is a big endian length followed by the bytes of an sf::Packet, so fields are read back the way
+//the network code writes them
+
+MatchRecordingHeader::MatchRecordingHeader()
+	: m_battlefield_size(0.f, 0.f)
+	, m_random_seed(0)
+	, m_tick_rate(sf::Time::Zero)
+	, m_max_connected_players(0)
+	, m_interest_radius(0.f)
+	, m_track_difficulty(1.f)
+	, m_peer_bandwidth(0.f)
+{
+}
+
+MatchEvent::MatchEvent()
+	: m_type(Type::kAdvance)
+	, m_elapsed(sf::Time::Zero)
+	, m_peer(0)
+{
+}
+
+MatchRecorder::MatchRecorder()
+	: m_peer_counter(0)
+{
+}
+
+bool MatchRecorder::Open(const std::string& path, const MatchRecordingHeader& header)
+{
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		return false;
+	}
+
+	sf::Packet record;
+	record << kRecordingMagic << kRecordingVersion;
+	record << header.m_battlefield_size.x << header.m_battlefield_size.y;
+	record << header.m_random_seed << static_cast<sf::Int64>(header.m_tick_rate.asMicroseconds());
+	record << header.m_max_connected_players << header.m_interest_radius << header.m_track_difficulty << header.m_peer_bandwidth;
+	Write(record);
+	return static_cast<bool>(m_file);
+}
+
+void MatchRecorder::RecordAdvance(sf::Time elapsed)
+{
+	sf::Packet record;
+	record << static_cast<sf::Uint8>(MatchEvent::Type::kAdvance) << static_cast<sf::Int64>(elapsed.asMicroseconds());
+	Write(record);
+}
+
+void MatchRecorder::RecordPeerConnected(const Connection* connection)
+{
+	//A connection allocated where a dropped one used to be is a new peer
+	m_peers[connection] = m_peer_counter;
+
+	sf::Packet record;
+	record << static_cast<sf::Uint8>(MatchEvent::Type::kPeerConnected) << m_peer_counter++;
+	Write(record);
+}
+
+void MatchRecorder::RecordPacket(const Connection* connection, const sf::Packet& packet)
+{
+	sf::Packet record;
+	record << static_cast<sf::Uint8>(MatchEvent::Type::kPacket) << m_peers[connection];
+	record.append(packet.getData(), packet.getDataSize());
+	Write(record);
+}
+
+void MatchRecorder::RecordPeerDropped(const Connection* connection)
+{
+	sf::Packet record;
+	record << static_cast<sf::Uint8>(MatchEvent::Type::kPeerDropped) << m_peers[connection];
+	Write(record);
+}
+
+void MatchRecorder::Write(const sf::Packet& record)
+{
+	if (!m_file)
+	{
+		return;
+	}
+
+	sf::Uint32 size = static_cast<sf::Uint32>(record.getDataSize());
+	char length[4] = { static_cast<char>(size >> 24), static_cast<char>(size >> 16), static_cast<char>(size >> 8), static_cast<char>(size) };
+	m_file.write(length, sizeof(length));
+	m_file.write(static_cast<const char*>(record.getData()), size);
+}
+
+bool MatchRecordingReader::Open(const std::string& path, MatchRecordingHeader& header)
+{
+	m_file.open(path, std::ios::binary);
+
+	sf::Packet record;
+	if (!m_file || !Read(record))
+	{
+		return false;
+	}
+
+	sf::Uint32 magic;
+	sf::Uint32 version;
+	sf::Int64 tick_rate;
+	record >> magic >> version;
+	record >> header.m_battlefield_size.x >> header.m_battlefield_size.y;
+	record >> header.m_random_seed >> tick_rate;
+	record >> header.m_max_connected_players >> header.m_interest_radius >> header.m_track_difficulty >> header.m_peer_bandwidth;
+	header.m_tick_rate = sf::microseconds(tick_rate);
+	return record && magic == kRecordingMagic && version == kRecordingVersion;
+}
+
+bool MatchRecordingReader::ReadEvent(MatchEvent& event)
+{
+	sf::Packet record;
+	if (!Read(record))
+	{
+		return false;
+	}
+
+	sf::Uint8 type;
+	record >> type;
+	event.m_type = static_cast<MatchEvent::Type>(type);
+	event.m_data.clear();
+
+	switch (event.m_type)
+	{
+	case MatchEvent::Type::kAdvance:
+	{
+		sf::Int64 elapsed;
+		record >> elapsed;
+		event.m_elapsed = sf::microseconds(elapsed);
+	}
+	break;
+
+	case MatchEvent::Type::kPacket:
+	{
+		record >> event.m_peer;
+		//The rest of the record is the packet as it arrived
+		const char* data = static_cast<const char*>(record.getData());
+		std::size_t offset = sizeof(sf::Uint8) + sizeof(sf::Uint32);
+		if (record.getDataSize() >= offset)
+		{
+			event.m_data.assign(data + offset, data + record.getDataSize());
+		}
+	}
+	break;
+
+	case MatchEvent::Type::kPeerConnected:
+	case MatchEvent::Type::kPeerDropped:
+		record >> event.m_peer;
+		break;
+
+	default:
+		return false;
+	}
+	return static_cast<bool>(record);
+}
+
+bool MatchRecordingReader::Read(sf::Packet& record)
+{
+	unsigned char length[4];
+	if (!m_file.read(reinterpret_cast<char*>(length), sizeof(length)))
+	{
+		return false;
+	}
+
+	sf::Uint32 size = (static_cast<sf::Uint32>(length[0]) << 24) | (static_cast<sf::Uint32>(length[1]) << 16)
+		| (static_cast<sf::Uint32>(length[2]) << 8) | static_cast<sf::Uint32>(length[3]);
+	if (size == 0 || size > kMaxRecordSize)
+	{
+		return false;
+	}
+
+	m_buffer.resize(size);
+	if (!m_file.read(m_buffer.data(), size))
+	{
+		return false;
+	}
+	record.append(m_buffer.data(), size);
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/Packet.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+class Connection;
+
+//What a match was started with, written at the start of its recording
+struct MatchRecordingHeader
+{
+	MatchRecordingHeader();
+	sf::Vector2f m_battlefield_size;
+	sf::Uint32 m_random_seed;
+	sf::Time m_tick_rate;
+	sf::Uint32 m_max_connected_players;
+	float m_interest_radius;
+	float m_track_difficulty;
+	float m_peer_bandwidth;
+};
+
+//Everything from outside that a match's behavior depends on. Peers are numbered in the order they connected
+struct MatchEvent
+{
+	enum class Type
+	{
+		//The server loop advanced by m_elapsed. Packets and drops recorded after it were handled during that Advance
+		kAdvance,
+		kPeerConnected,
+		kPacket,
+		//The transport lost the peer, a peer that says goodbye sends a Quit packet instead
+		kPeerDropped
+	};
+
+	MatchEvent();
+	Type m_type;
+	sf::Time m_elapsed;
+	sf::Uint32 m_peer;
+	std::vector<char> m_data;
+};
+
+//Appends a match's events to a file as they happen, so a match can be replayed without sockets or a clock
+class MatchRecorder
+{
+public:
+	MatchRecorder();
+	bool Open(const std::string& path, const MatchRecordingHeader& header);
+
+	void RecordAdvance(sf::Time elapsed);
+	void RecordPeerConnected(const Connection* connection);
+	void RecordPacket(const Connection* connection, const sf::Packet& packet);
+	void RecordPeerDropped(const Connection* connection);
+
+private:
+	void Write(const sf::Packet& record);
+
+private:
+	std::ofstream m_file;
+	std::map<const Connection*, sf::Uint32> m_peers;
+	sf::Uint32 m_peer_counter;
+};
+
+class MatchRecordingReader
+{
+public:
+	bool Open(const std::string& path, MatchRecordingHeader& header);
+	//False at the end of the recording or if it is cut short
+	bool ReadEvent(MatchEvent& event);
+
+private:
+	bool Read(sf::Packet& record);
+
+private:
+	std::ifstream m_file;
+	std::vector<char> m_buffer;
+};
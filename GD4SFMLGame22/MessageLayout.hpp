@@ -0,0 +1,239 @@
+#pragma once
+#include <string>
+
+#include <SFML/Config.hpp>
+
+#include "NetworkProtocol.hpp"
+
+//The fields every message starts with after its Int32 packet type, in order. MessageWriter::WriteMessage only
+//compiles when given exactly these types, so a sender and this list cannot drift apart unnoticed.
+//Messages with a variable part note what follows the fixed fields
+template <typename... Fields>
+struct MessageFields
+{
+};
+
+namespace ServerMessage
+{
+	struct BroadcastMessage
+	{
+		static const Server::PacketType kType = Server::PacketType::BroadcastMessage;
+		typedef MessageFields<std::string> Fields;
+	};
+
+	//World width, battlefield height, track seed, track difficulty and the left edge of the view. The rest of the
+	//match's state follows in JoinSnapshot chunks
+	struct InitialState
+	{
+		static const Server::PacketType kType = Server::PacketType::InitialState;
+		typedef MessageFields<float, float, sf::Uint32, float, float> Fields;
+	};
+
+	//Section, entry count and whether this is the section's last chunk, then per entry:
+	//bikes: Int32 identifier, Uint16 x and y quantized as in snapshots, Int16 hitpoints and bool boost
+	//dropped pickups: Uint8 type, float x and float y
+	//track obstacles and pickups: Uint16 count of track indices skipped since the section's previous entry, or since 0
+	//The last chunk of a track section then has a Uint32 count of the entities of its kind the track has generated
+	struct JoinSnapshot
+	{
+		static const Server::PacketType kType = Server::PacketType::JoinSnapshot;
+		typedef MessageFields<sf::Uint8, sf::Uint16, bool> Fields;
+	};
+
+	//Bike identifier and action
+	struct PlayerEvent
+	{
+		static const Server::PacketType kType = Server::PacketType::PlayerEvent;
+		typedef MessageFields<sf::Int32, sf::Int32> Fields;
+	};
+
+	//Bike identifier, action and whether it is now enabled
+	struct PlayerRealtimeChange
+	{
+		static const Server::PacketType kType = Server::PacketType::PlayerRealtimeChange;
+		typedef MessageFields<sf::Int32, sf::Int32, bool> Fields;
+	};
+
+	//Bike identifier and position
+	struct PlayerConnect
+	{
+		static const Server::PacketType kType = Server::PacketType::PlayerConnect;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	struct PlayerDisconnect
+	{
+		static const Server::PacketType kType = Server::PacketType::PlayerDisconnect;
+		typedef MessageFields<sf::Int32> Fields;
+	};
+
+	//Bike identifier and position
+	struct AcceptCoopPartner
+	{
+		static const Server::PacketType kType = Server::PacketType::AcceptCoopPartner;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	//Pickup type and position
+	struct SpawnPickup
+	{
+		static const Server::PacketType kType = Server::PacketType::SpawnPickup;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	//Bike identifier and position
+	struct SpawnSelf
+	{
+		static const Server::PacketType kType = Server::PacketType::SpawnSelf;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	//Followed by a snapshot delta from SnapshotCodec::WriteDelta
+	struct UpdateClientState
+	{
+		static const Server::PacketType kType = Server::PacketType::UpdateClientState;
+		typedef MessageFields<> Fields;
+	};
+
+	struct MissionSuccess
+	{
+		static const Server::PacketType kType = Server::PacketType::MissionSuccess;
+		typedef MessageFields<> Fields;
+	};
+
+	struct MissionFail
+	{
+		static const Server::PacketType kType = Server::PacketType::MissionFail;
+		typedef MessageFields<> Fields;
+	};
+
+	struct ServerStart
+	{
+		static const Server::PacketType kType = Server::PacketType::ServerStart;
+		typedef MessageFields<> Fields;
+	};
+
+	struct PlayerCountUpdate
+	{
+		static const Server::PacketType kType = Server::PacketType::PlayerCountUpdate;
+		typedef MessageFields<sf::Int32> Fields;
+	};
+
+	//Bike identifier and position
+	struct BikeEnterInterest
+	{
+		static const Server::PacketType kType = Server::PacketType::BikeEnterInterest;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	struct BikeLeaveInterest
+	{
+		static const Server::PacketType kType = Server::PacketType::BikeLeaveInterest;
+		typedef MessageFields<sf::Int32> Fields;
+	};
+
+	struct MatchJoined
+	{
+		static const Server::PacketType kType = Server::PacketType::MatchJoined;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+
+	//The server's clock in milliseconds
+	struct Ping
+	{
+		static const Server::PacketType kType = Server::PacketType::Ping;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+
+	//The timestamp of the client's Ping
+	struct Pong
+	{
+		static const Server::PacketType kType = Server::PacketType::Pong;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+}
+
+namespace ClientMessage
+{
+	//Bike identifier and action
+	struct PlayerEvent
+	{
+		static const Client::PacketType kType = Client::PacketType::PlayerEvent;
+		typedef MessageFields<sf::Int32, sf::Int32> Fields;
+	};
+
+	//Bike identifier, action and whether it is now enabled
+	struct PlayerRealtimeChange
+	{
+		static const Client::PacketType kType = Client::PacketType::PlayerRealtimeChange;
+		typedef MessageFields<sf::Int32, sf::Int32, bool> Fields;
+	};
+
+	struct RequestCoopPartner
+	{
+		static const Client::PacketType kType = Client::PacketType::RequestCoopPartner;
+		typedef MessageFields<> Fields;
+	};
+
+	//Newest snapshot sequence received
+	struct SnapshotAck
+	{
+		static const Client::PacketType kType = Client::PacketType::SnapshotAck;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+
+	//Action and position
+	struct GameEvent
+	{
+		static const Client::PacketType kType = Client::PacketType::GameEvent;
+		typedef MessageFields<sf::Int32, float, float> Fields;
+	};
+
+	struct Quit
+	{
+		static const Client::PacketType kType = Client::PacketType::Quit;
+		typedef MessageFields<> Fields;
+	};
+
+	//Newest snapshot sequence received, the lobby acknowledges snapshots with this, and a bike count followed by
+	//that many Int32 bike identifiers
+	struct PauseLobbyUpdate
+	{
+		static const Client::PacketType kType = Client::PacketType::PauseLobbyUpdate;
+		typedef MessageFields<sf::Uint32, sf::Int32> Fields;
+	};
+
+	struct ClientStart
+	{
+		static const Client::PacketType kType = Client::PacketType::ClientStart;
+		typedef MessageFields<> Fields;
+	};
+
+	//Bike identifier and command count, then per command its Uint32 sequence and Uint8 input bits
+	struct PlayerInput
+	{
+		static const Client::PacketType kType = Client::PacketType::PlayerInput;
+		typedef MessageFields<sf::Int32, sf::Uint8> Fields;
+	};
+
+	//Requested match, 0 for any
+	struct JoinMatch
+	{
+		static const Client::PacketType kType = Client::PacketType::JoinMatch;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+
+	//The client's clock in milliseconds
+	struct Ping
+	{
+		static const Client::PacketType kType = Client::PacketType::Ping;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+
+	//The timestamp of the server's Ping
+	struct Pong
+	{
+		static const Client::PacketType kType = Client::PacketType::Pong;
+		typedef MessageFields<sf::Uint32> Fields;
+	};
+}
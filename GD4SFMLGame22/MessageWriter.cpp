@@ -0,0 +1,82 @@
+#include "MessageWriter.hpp"
+
+//Integers go out most significant byte first and floats as their raw bytes, the same as sf::Packet
+
+MessageWriter::MessageWriter(std::vector<char>& buffer)
+	: m_buffer(buffer)
+{
+	m_buffer.clear();
+}
+
+MessageWriter& MessageWriter::operator<<(bool value)
+{
+	return *this << static_cast<sf::Uint8>(value);
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Int8 value)
+{
+	return *this << static_cast<sf::Uint8>(value);
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Uint8 value)
+{
+	m_buffer.push_back(static_cast<char>(value));
+	return *this;
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Int16 value)
+{
+	return *this << static_cast<sf::Uint16>(value);
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Uint16 value)
+{
+	char bytes[2] = { static_cast<char>(value >> 8), static_cast<char>(value) };
+	Append(bytes, sizeof(bytes));
+	return *this;
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Int32 value)
+{
+	return *this << static_cast<sf::Uint32>(value);
+}
+
+MessageWriter& MessageWriter::operator<<(sf::Uint32 value)
+{
+	char bytes[4] = { static_cast<char>(value >> 24), static_cast<char>(value >> 16), static_cast<char>(value >> 8), static_cast<char>(value) };
+	Append(bytes, sizeof(bytes));
+	return *this;
+}
+
+MessageWriter& MessageWriter::operator<<(float value)
+{
+	Append(&value, sizeof(value));
+	return *this;
+}
+
+MessageWriter& MessageWriter::operator<<(const std::string& value)
+{
+	*this << static_cast<sf::Uint32>(value.size());
+	Append(value.data(), value.size());
+	return *this;
+}
+
+const char* MessageWriter::GetData() const
+{
+	return m_buffer.data();
+}
+
+std::size_t MessageWriter::GetSize() const
+{
+	return m_buffer.size();
+}
+
+void MessageWriter::WriteFields()
+{
+}
+
+void MessageWriter::Append(const void* data, std::size_t size)
+{
+	const char* bytes = static_cast<const char*>(data);
+	m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <SFML/Config.hpp>
+
+#include "MessageLayout.hpp"
+
+//Writes a message into a buffer that is reused from one message to the next, so once the buffer has grown to fit
+//the largest message nothing is allocated. The bytes are laid out exactly as sf::Packet lays them out, so the
+//receiving side reads them with sf::Packet as before
+class MessageWriter
+{
+public:
+	//Clears the buffer but keeps its capacity
+	explicit MessageWriter(std::vector<char>& buffer);
+
+	//Writes the packet type and fixed fields of a message from MessageLayout.hpp. The arguments have to be of
+	//exactly the layout's field types, anything else does not compile. Variable parts follow with <<
+	template <typename Layout, typename... Args>
+	MessageWriter& WriteMessage(const Args&... args);
+
+	MessageWriter& operator<<(bool value);
+	MessageWriter& operator<<(sf::Int8 value);
+	MessageWriter& operator<<(sf::Uint8 value);
+	MessageWriter& operator<<(sf::Int16 value);
+	MessageWriter& operator<<(sf::Uint16 value);
+	MessageWriter& operator<<(sf::Int32 value);
+	MessageWriter& operator<<(sf::Uint32 value);
+	MessageWriter& operator<<(float value);
+	MessageWriter& operator<<(const std::string& value);
+
+	const char* GetData() const;
+	std::size_t GetSize() const;
+
+private:
+	void WriteFields();
+	template <typename Field, typename... Rest>
+	void WriteFields(const Field& field, const Rest&... rest);
+	void Append(const void* data, std::size_t size);
+
+private:
+	std::vector<char>& m_buffer;
+};
+
+template <typename Layout, typename... Args>
+MessageWriter& MessageWriter::WriteMessage(const Args&... args)
+{
+	static_assert(std::is_same<typename Layout::Fields, MessageFields<Args...>>::value, "Arguments do not match the message's layout");
+	*this << static_cast<sf::Int32>(Layout::kType);
+	WriteFields(args...);
+	return *this;
+}
+
+template <typename Field, typename... Rest>
+void MessageWriter::WriteFields(const Field& field, const Rest&... rest)
+{
+	*this << field;
+	WriteFields(rest...);
+}
@@ -10,8 +10,16 @@
 #include <SFML/Network/Packet.hpp>
 
 
+#include "MessageWriter.hpp"
 #include "PickupType.hpp"
 
+namespace
+{
+	//PredictedBike repeats up to 16 unacknowledged inputs, so this many frames between sends loses nothing
+	const std::size_t kMaxInputInterval = 3;
+	const sf::Time kConnectTimeout = sf::seconds(5.f);
+}
+
 sf::IpAddress GetAddressFromFile()
 {
 	{
@@ -36,7 +44,8 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 , m_world(*context.window, *context.fonts, *context.sounds, true)
 , m_window(*context.window)
 , m_texture_holder(*context.textures)
-, m_connected(false)
+, m_connection(nullptr)
+, m_connection_phase(ConnectionPhase::kConnecting)
 , m_game_server(nullptr)
 , m_active_state(true)
 , m_has_focus(true)
@@ -46,30 +55,32 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 , m_time_since_last_packet(sf::seconds(0.f))
 , m_in_lobby(true)
 , m_player_count(0)
+, m_last_snapshot(0)
+, m_join_cursor(0)
+, m_since_ping(sf::Time::Zero)
+, m_show_network_statistics(false)
+, m_input_rate(kMaxInputInterval, 0.f)
 {
 	m_broadcast_text.setFont(context.fonts->Get(Fonts::Main));
 	m_broadcast_text.setPosition(1024.f - 200.f, 600.f);
 
+	//Below the frame statistics Application draws
+	m_network_statistics_text.setFont(context.fonts->Get(Fonts::Main));
+	m_network_statistics_text.setPosition(5.f, 40.f);
+	m_network_statistics_text.setCharacterSize(10u);
+
 	m_player_invitation_text.setFont(context.fonts->Get(Fonts::Main));
 	m_player_invitation_text.setCharacterSize(20);
 	m_player_invitation_text.setFillColor(sf::Color::White);
 	m_player_invitation_text.setString("Press Enter to spawn player 2");
 	m_player_invitation_text.setPosition(1000 - m_player_invitation_text.getLocalBounds().width, 760 - m_player_invitation_text.getLocalBounds().height);
 
-	//We reuse this text for "Attempt to connect" and "Failed to connect" messages
+	//We reuse this text for the "Attempting to connect", "Joining" and "Failed to connect" messages
 	m_failed_connection_text.setFont(context.fonts->Get(Fonts::Main));
-	m_failed_connection_text.setString("Attempting to connect...");
 	m_failed_connection_text.setCharacterSize(35);
 	m_failed_connection_text.setFillColor(sf::Color::White);
-	Utility::CentreOrigin(m_failed_connection_text);
 	m_failed_connection_text.setPosition(m_window.getSize().x / 2.f, m_window.getSize().y / 2.f);
-
-	//Render an "establishing connection" frame for user feedback
-	m_window.clear(sf::Color::Black);
-	m_window.draw(m_failed_connection_text);
-	m_window.display();
-	m_failed_connection_text.setString("Could not connect to the remote server");
-	Utility::CentreOrigin(m_failed_connection_text);
+	SetConnectionMessage("Attempting to connect...");
 
 	//lobby text
 	m_in_lobby_text.setFont(context.fonts->Get(Fonts::Main));
@@ -87,21 +98,21 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 	Utility::CentreOrigin(m_in_lobby_player_count_text);
 	m_in_lobby_player_count_text.setPosition(m_failed_connection_text.getPosition().x, m_failed_connection_text.getPosition().y+50);
 
-	sf::IpAddress ip;
 	if(m_host)
 	{
 		//++m_player_count;
+		//The host's own client skips the socket, its connection is there from the start
 		m_game_server.reset(new GameServer(sf::Vector2f(m_window.getSize())));
-		ip = "127.0.0.1";
+		m_local_connection = m_game_server->ConnectLocal();
+		m_connection = m_local_connection.get();
 
 		auto startButton = std::make_shared<GUI::Button>(context);
 		startButton->setPosition(m_window.getSize().x /2.f, m_window.getSize().y/3.f);
 		startButton->SetText("Start");
 		startButton->SetCallback([this]()
 			{
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Client::PacketType::ClientStart);
-				m_socket.send(packet);
+				MessageWriter message(m_message_buffer);
+				m_connection->Send(message.WriteMessage<ClientMessage::ClientStart>(), Delivery::kReliableOrdered);
 			});
 
 		auto backToMenuButton = std::make_shared<GUI::Button>(context);
@@ -118,19 +129,10 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 	}
 	else
 	{
-		ip = GetAddressFromFile();
+		//Only sends the first connection request, UpdateConnecting waits for the answer
+		m_connection = m_network_host.Connect(GetAddressFromFile(), SERVER_PORT);
 	}
-
-	if(m_socket.connect(ip, SERVER_PORT, sf::seconds(5.f)) == sf::TcpSocket::Done)
-	{
-		m_connected = true;
-	}
-	else
-	{
-		m_failed_connection_clock.restart();
-	}
-
-	m_socket.setBlocking(false);
+	m_connect_clock.restart();
 
 	//Play game theme
 	context.music->Play(MusicThemes::kMissionTheme);
@@ -138,7 +140,7 @@ MultiplayerGameState::MultiplayerGameState(StateStack& stack, Context context, b
 
 void MultiplayerGameState::Draw()
 {
-	if(m_connected)
+	if(m_connection_phase == ConnectionPhase::kConnected)
 	{
 		//Show broadcast messages in default view
 		m_window.setView(m_window.getDefaultView());
@@ -166,6 +168,11 @@ void MultiplayerGameState::Draw()
 				m_window.draw(m_player_invitation_text);
 			}
 		}
+
+		if (m_show_network_statistics)
+		{
+			m_window.draw(m_network_statistics_text);
+		}
 	}
 	
 	else
@@ -176,8 +183,13 @@ void MultiplayerGameState::Draw()
 
 bool MultiplayerGameState::Update(sf::Time dt)
 {
+	if (m_connection_phase == ConnectionPhase::kConnecting)
+	{
+		UpdateConnecting();
+	}
+
 	//Connected to the Server: Handle all the network logic
-	if (m_connected)
+	if (HasConnection())
 	{
 		if (m_in_lobby)
 		{
@@ -186,19 +198,28 @@ bool MultiplayerGameState::Update(sf::Time dt)
 
 			if (m_tick_clock.getElapsedTime() > sf::seconds(1.f / 20.f))
 			{
-				sf::Packet pause_update_packet;
-				pause_update_packet << static_cast<sf::Int32>(Client::PacketType::PauseLobbyUpdate);
-				pause_update_packet << static_cast<sf::Int32>(m_local_player_identifiers.size());
+				//Only bikes that exist are listed, so count those first
+				sf::Int32 bike_count = 0;
+				for (sf::Int32 identifier : m_local_player_identifiers)
+				{
+					if (m_world.GetBike(identifier))
+					{
+						++bike_count;
+					}
+				}
+
+				MessageWriter pause_update_message(m_message_buffer);
+				pause_update_message.WriteMessage<ClientMessage::PauseLobbyUpdate>(m_last_snapshot, bike_count);
 
 				for (sf::Int32 identifier : m_local_player_identifiers)
 				{
 					if (Bike* bike = m_world.GetBike(identifier))
 					{
-						pause_update_packet << identifier;
-						//pause_update_packet << identifier << bike->getPosition().x << bike->getPosition().y << static_cast<sf::Int32>(bike->GetHitPoints()) << bike->GetBoost();
+						pause_update_message << identifier;
+						//pause_update_message << identifier << bike->getPosition().x << bike->getPosition().y << static_cast<sf::Int32>(bike->GetHitPoints()) << bike->GetBoost();
 					}
 				}
-				m_socket.send(pause_update_packet);
+				m_connection->Send(pause_update_message, Delivery::kUnreliableSequenced);
 				m_tick_clock.restart();
 			}
 			m_time_since_last_packet += dt;
@@ -221,6 +242,7 @@ bool MultiplayerGameState::Update(sf::Time dt)
 
 				if (!m_world.GetBike(itr->first))
 				{
+					m_predicted_bikes.erase(itr->first);
 					itr = m_players.erase(itr);
 
 					//No more players left : Mission failed
@@ -241,21 +263,45 @@ bool MultiplayerGameState::Update(sf::Time dt)
 				RequestStackPush(StateID::kGameOver);
 			}
 
-			//Only handle the realtime input if the window has focus and the game is unpaused
-			if (m_active_state && m_has_focus)
+			//Our own bikes run ahead of the server from local input; every frame's input is sent so the server can replay it.
+			//Input only counts if the window has focus and the game is unpaused
+			sf::FloatRect view_bounds = m_world.GetViewBounds();
+			bool send_input = m_input_rate.ShouldSend(dt);
+			for (auto& pair : m_predicted_bikes)
 			{
-				CommandQueue& commands = m_world.GetCommandQueue();
-				for (auto& pair : m_players)
+				InputBits input = 0;
+				if (m_active_state && m_has_focus)
+				{
+					input = m_players[pair.first]->GetRealtimeInput();
+				}
+
+				const BikeMotion& motion = pair.second.Step(input, dt, view_bounds);
+				if (Bike* bike = m_world.GetBike(pair.first))
+				{
+					bike->setPosition(motion.m_position);
+					bike->SetVelocity(motion.m_velocity);
+				}
+
+				//Unacknowledged inputs are repeated in every packet, so a lost one does not need resending
+				if (send_input)
 				{
-					pair.second->HandleRealtimeInput(commands);
+					MessageWriter message(m_message_buffer);
+					pair.second.WriteInputs(message, pair.first);
+					m_connection->Send(message, Delivery::kUnreliableSequenced);
 				}
 			}
 
-			//Always handle the network input
-			CommandQueue& commands = m_world.GetCommandQueue();
+			//Everyone else's bikes are drawn from the buffered server snapshots
+			m_snapshot_buffer.Advance(dt);
 			for (auto& pair : m_players)
 			{
-				pair.second->HandleRealtimeNetworkInput(commands);
+				Bike* bike = m_world.GetBike(pair.first);
+				sf::Vector2f position, velocity;
+				if (bike && m_predicted_bikes.count(pair.first) == 0 && m_snapshot_buffer.Sample(pair.first, position, velocity))
+				{
+					bike->setPosition(position);
+					bike->SetVelocity(velocity);
+				}
 			}
 
 			CheckPacket();
@@ -272,38 +318,37 @@ bool MultiplayerGameState::Update(sf::Time dt)
 			GameActions::Action game_action;
 			while (m_world.PollGameAction(game_action))
 			{
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Client::PacketType::GameEvent);
-				packet << static_cast<sf::Int32>(game_action.type);
-				packet << game_action.position.x;
-				packet << game_action.position.y;
+				MessageWriter message(m_message_buffer);
+				message.WriteMessage<ClientMessage::GameEvent>(static_cast<sf::Int32>(game_action.type), game_action.position.x, game_action.position.y);
 
-				m_socket.send(packet);
+				m_connection->Send(message, Delivery::kReliableOrdered);
 			}
 
-			//Regular position updates
+			//Regular snapshot acknowledgements. The server simulates the bikes from our input, so no positions are sent
 			if (m_tick_clock.getElapsedTime() > sf::seconds(1.f / 20.f))
 			{
-				sf::Packet position_update_packet;
-				position_update_packet << static_cast<sf::Int32>(Client::PacketType::PositionUpdate);
-				position_update_packet << static_cast<sf::Int32>(m_local_player_identifiers.size());
-
-				for (sf::Int32 identifier : m_local_player_identifiers)
-				{
-					if (Bike* bike = m_world.GetBike(identifier))
-					{
-						position_update_packet << identifier << bike->getPosition().x << bike->getPosition().y << static_cast<sf::Int32>(bike->GetHitPoints()) << bike->GetBoost();
-					}
-				}
-				m_socket.send(position_update_packet);
+				//Acknowledge the newest snapshot so the server can delta against it
+				MessageWriter ack_message(m_message_buffer);
+				ack_message.WriteMessage<ClientMessage::SnapshotAck>(m_last_snapshot);
+				m_connection->Send(ack_message, Delivery::kUnreliableSequenced);
 				m_tick_clock.restart();
 			}
 			m_time_since_last_packet += dt;
 		}
+
+		UpdateNetworkStatistics(dt);
+
+		//Send everything queued this frame in one datagram, resend unacknowledged reliable messages
+		//and keep the connection alive
+		m_network_host.Update();
+		if (m_local_connection)
+		{
+			m_local_connection->Flush();
+		}
 	}
 
 	//Failed to connect and waited for more than 5 seconds: Back to menu
-	else if(m_failed_connection_clock.getElapsedTime() >= sf::seconds(5.f))
+	else if(m_connection_phase == ConnectionPhase::kDisconnected && m_failed_connection_clock.getElapsedTime() >= sf::seconds(5.f))
 	{
 		RequestStackClear();
 		RequestStackPush(StateID::kMenu);
@@ -311,31 +356,93 @@ bool MultiplayerGameState::Update(sf::Time dt)
 	return true;
 }
 
+bool MultiplayerGameState::HasConnection() const
+{
+	return m_connection_phase == ConnectionPhase::kJoining || m_connection_phase == ConnectionPhase::kConnected;
+}
+
+void MultiplayerGameState::UpdateConnecting()
+{
+	//The host resends the connection request, less often the longer the server takes to answer
+	m_network_host.Receive();
+	m_network_host.Update();
+
+	if (m_connection && m_connection->IsConnected())
+	{
+		m_connection_phase = ConnectionPhase::kJoining;
+		m_time_since_last_packet = sf::Time::Zero;
+		SetConnectionMessage("Joining match...");
+
+		//Dedicated servers run several matches and put us in one with room, a listen server ignores this
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::JoinMatch>(static_cast<sf::Uint32>(0));
+		m_connection->Send(message, Delivery::kReliableOrdered);
+	}
+	else if (!m_connection || m_connect_clock.getElapsedTime() >= kConnectTimeout)
+	{
+		m_connection_phase = ConnectionPhase::kDisconnected;
+		SetConnectionMessage("Could not connect to the remote server");
+		m_failed_connection_clock.restart();
+	}
+}
+
+void MultiplayerGameState::SetConnectionMessage(const std::string& message)
+{
+	m_failed_connection_text.setString(message);
+	Utility::CentreOrigin(m_failed_connection_text);
+}
+
 void MultiplayerGameState::UpdatePlayerCountConnected(sf::Time dt)
 {
 	m_in_lobby_player_count_text.setString("Player Connected : " + std::to_string(m_player_count));
 }
 
 
+void MultiplayerGameState::UpdateNetworkStatistics(sf::Time dt)
+{
+	m_network_statistics.Update(m_connection->GetTraffic(), dt);
+	m_input_rate.Update(m_network_statistics, dt);
+
+	m_since_ping += dt;
+	if (m_since_ping < NetworkStatistics::kPingInterval)
+	{
+		return;
+	}
+	m_since_ping = sf::Time::Zero;
+
+	MessageWriter message(m_message_buffer);
+	message.WriteMessage<ClientMessage::Ping>(NetworkStatistics::ToTimestamp(m_ping_clock.getElapsedTime()));
+	m_connection->Send(message, Delivery::kUnreliableSequenced);
+
+	//Refreshed with each Ping rather than every frame
+	m_network_statistics_text.setString(m_network_statistics.ToString() + "\n" +
+		"Snapshots Buffered = " + std::to_string(m_snapshot_buffer.GetDepth()) + " (" + std::to_string(m_snapshot_buffer.GetBufferedTime().asMilliseconds()) + "ms)\n" +
+		"Input Every " + std::to_string(m_input_rate.GetInterval()) + " Frames");
+}
+
 void MultiplayerGameState::CheckPacket()
 {
-	//Handle messages from the server that may have arrived
-	sf::Packet packet;
-	if (m_socket.receive(packet) == sf::Socket::Done)
+	//Handle all messages from the server that have arrived since the last frame
+	m_network_host.Receive();
+
+	sf::Packet& packet = m_receive_packet;
+	bool received = false;
+	while (HasConnection() && m_connection->Receive(packet))
 	{
+		received = true;
 		m_time_since_last_packet = sf::seconds(0.f);
 		sf::Int32 packet_type;
 		packet >> packet_type;
 		HandlePacket(packet_type, packet);
 	}
-	else
+
+	if (!received)
 	{
-		//Check for timeout with the server
-		if (m_time_since_last_packet > m_client_timeout)
+		//Check for timeout with the server, or the server closing the connection
+		if (m_time_since_last_packet > m_client_timeout || !m_connection->IsConnected())
 		{
-			m_connected = false;
-			m_failed_connection_text.setString("Lost connection to the server");
-			Utility::CentreOrigin(m_failed_connection_text);
+			m_connection_phase = ConnectionPhase::kDisconnected;
+			SetConnectionMessage("Lost connection to the server");
 
 			m_failed_connection_clock.restart();
 		}
@@ -345,7 +452,16 @@ void MultiplayerGameState::CheckPacket()
 
 bool MultiplayerGameState::HandleEvent(const sf::Event& event)
 {
-	if(m_in_lobby && m_host)
+	//Until the match has been joined the only thing to do is give up on it
+	if(m_connection_phase != ConnectionPhase::kConnected)
+	{
+		if(event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
+		{
+			RequestStackClear();
+			RequestStackPush(StateID::kMenu);
+		}
+	}
+	else if(m_in_lobby && m_host)
 	{
 		m_in_lobby_ui.HandleEvent(event);
 	}
@@ -365,9 +481,8 @@ bool MultiplayerGameState::HandleEvent(const sf::Event& event)
 		//If enter pressed, add second player co-op only if there is only 1 player
 		if(event.key.code == sf::Keyboard::Return && m_local_player_identifiers.size()==1)
 		{
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Client::PacketType::RequestCoopPartner);
-			m_socket.send(packet);
+			MessageWriter message(m_message_buffer);
+			m_connection->Send(message.WriteMessage<ClientMessage::RequestCoopPartner>(), Delivery::kReliableOrdered);
 		}
 		//If escape is pressed, show the pause screen
 		else if(event.key.code == sf::Keyboard::Escape)
@@ -375,6 +490,10 @@ bool MultiplayerGameState::HandleEvent(const sf::Event& event)
 			DisableAllRealtimeActions();
 			RequestStackPush(StateID::kNetworkPause);
 		}
+		else if(event.key.code == sf::Keyboard::F3)
+		{
+			m_show_network_statistics = !m_show_network_statistics;
+		}
 	}
 	else if(event.type == sf::Event::GainedFocus)
 	{
@@ -395,12 +514,12 @@ void MultiplayerGameState::OnActivate()
 
 void MultiplayerGameState::OnDestroy()
 {
-	if(!m_host && m_connected)
+	if(!m_host && HasConnection())
 	{
 		//Inform server this client is dying
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Client::PacketType::Quit);
-		m_socket.send(packet);
+		MessageWriter message(m_message_buffer);
+		m_connection->Send(message.WriteMessage<ClientMessage::Quit>(), Delivery::kReliableOrdered);
+		m_connection->Flush();
 	}
 }
 
@@ -466,8 +585,10 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 		packet >> bike_identifier >> bike_position.x >> bike_position.y;
 		Bike* bike = m_world.AddBike(bike_identifier);
 		bike->setPosition(bike_position);
-		m_players[bike_identifier].reset(new Player(&m_socket, bike_identifier, GetContext().keys1));
+		bike->SetNetworkDriven(true);
+		m_players[bike_identifier].reset(new Player(m_connection, bike_identifier, GetContext().keys1));
 		m_local_player_identifiers.push_back(bike_identifier);
+		m_predicted_bikes.emplace(bike_identifier, PredictedBike(bike_position));
 		m_game_started = true;
 	}
 	break;
@@ -480,18 +601,47 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 
 		Bike* bike = m_world.AddBike(bike_identifier);
 		bike->setPosition(bike_position);
-		m_players[bike_identifier].reset(new Player(&m_socket, bike_identifier, nullptr));
+		bike->SetNetworkDriven(true);
+		m_players[bike_identifier].reset(new Player(m_connection, bike_identifier, nullptr));
 
 		//++m_player_count;
 	}
 	break;
 
+	//Another bike came near ours, it may already be known from PlayerConnect
+	case Server::PacketType::BikeEnterInterest:
+	{
+		sf::Int32 bike_identifier;
+		sf::Vector2f bike_position;
+		packet >> bike_identifier >> bike_position.x >> bike_position.y;
+
+		if (!m_world.GetBike(bike_identifier))
+		{
+			Bike* bike = m_world.AddBike(bike_identifier);
+			bike->setPosition(bike_position);
+			bike->SetNetworkDriven(true);
+			m_players[bike_identifier].reset(new Player(m_connection, bike_identifier, nullptr));
+		}
+	}
+	break;
+
+	//Out of range rather than destroyed, so it just disappears
+	case Server::PacketType::BikeLeaveInterest:
+	{
+		sf::Int32 bike_identifier;
+		packet >> bike_identifier;
+		m_world.RemoveBike(bike_identifier, false);
+		m_players.erase(bike_identifier);
+	}
+	break;
+
 	case Server::PacketType::PlayerDisconnect:
 	{
 		sf::Int32 bike_identifier;
 		packet >> bike_identifier;
 		m_world.RemoveBike(bike_identifier);
 		m_players.erase(bike_identifier);
+		m_predicted_bikes.erase(bike_identifier);
 
 		//--m_player_count;
 	}
@@ -499,28 +649,105 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 
 	case Server::PacketType::InitialState:
 	{
-		sf::Int32 bike_count;
-		float world_height, current_scroll;
+		float world_height, current_scroll, view_left;
 		packet >> world_height >> current_scroll;
 
 		m_world.SetWorldHeight(world_height);
 		m_world.SetCurrentBattleFieldPosition(current_scroll);
 
-		packet >> bike_count;
-		for (sf::Int32 i = 0; i < bike_count; ++i)
+		//These are the server's world width and battlefield height, which define the snapshot quantization range
+		m_snapshot_codec = SnapshotCodec(sf::Vector2f(world_height, current_scroll));
+
+		//The track is laid out from the same settings as on the server, rather than streamed, once the join
+		//snapshot has said which of its obstacles and pickups are already gone
+		m_join_track = TrackSettings();
+		packet >> m_join_track.m_seed >> m_join_track.m_difficulty >> view_left;
+		m_join_track.m_length = world_height;
+		m_join_progress = TrackProgress();
+		m_join_cursor = 0;
+
+		m_world.SetScrollPosition(view_left);
+	}
+	break;
+
+	//The rest of the match's state, see GameServer::SendJoinSnapshot
+	case Server::PacketType::JoinSnapshot:
+	{
+		sf::Uint8 section;
+		sf::Uint16 count;
+		bool last;
+		packet >> section >> count >> last;
+
+		switch (static_cast<Server::JoinSnapshotSection>(section))
 		{
-			sf::Int32 bike_identifier;
-			sf::Int32 hitpoints;
-			bool boost;
-			sf::Vector2f bike_position;
-			packet >> bike_identifier >> bike_position.x >> bike_position.y >> hitpoints >> boost;
+		case Server::JoinSnapshotSection::kBikes:
+			for (sf::Uint16 i = 0; i < count; ++i)
+			{
+				sf::Int32 bike_identifier;
+				BikeSnapshot state;
+				packet >> bike_identifier >> state.m_x >> state.m_y >> state.m_hitpoints >> state.m_boost;
+				if (m_world.GetBike(bike_identifier))
+				{
+					continue;
+				}
 
-			Bike* bike = m_world.AddBike(bike_identifier);
-			bike->setPosition(bike_position);
-			bike->SetHitpoints(hitpoints);
-			bike->SetBoost(boost);
+				Bike* bike = m_world.AddBike(bike_identifier);
+				bike->setPosition(m_snapshot_codec.GetPosition(state));
+				bike->SetHitpoints(state.m_hitpoints);
+				bike->SetBoost(state.m_boost);
+				bike->SetNetworkDriven(true);
+
+				m_players[bike_identifier].reset(new Player(m_connection, bike_identifier, nullptr));
+			}
+			break;
+
+		case Server::JoinSnapshotSection::kDroppedPickups:
+			for (sf::Uint16 i = 0; i < count; ++i)
+			{
+				sf::Uint8 type;
+				sf::Vector2f position;
+				packet >> type >> position.x >> position.y;
+				m_world.CreatePickup(position, static_cast<PickupType>(type));
+			}
+			break;
+
+		case Server::JoinSnapshotSection::kTrackObstacles:
+			for (sf::Uint16 i = 0; i < count; ++i)
+			{
+				sf::Uint16 skipped;
+				packet >> skipped;
+				m_join_cursor += skipped;
+				m_join_progress.m_live_obstacles.push_back(m_join_cursor++);
+			}
+			if (last)
+			{
+				packet >> m_join_progress.m_obstacle_count;
+				m_join_cursor = 0;
+			}
+			break;
+
+		case Server::JoinSnapshotSection::kTrackPickups:
+			for (sf::Uint16 i = 0; i < count; ++i)
+			{
+				sf::Uint16 skipped;
+				packet >> skipped;
+				m_join_cursor += skipped;
+				m_join_progress.m_live_pickups.push_back(m_join_cursor++);
+			}
+			if (last)
+			{
+				packet >> m_join_progress.m_pickup_count;
+				m_join_cursor = 0;
 
-			m_players[bike_identifier].reset(new Player(&m_socket, bike_identifier, nullptr));
+				//The match is ready to be shown
+				m_world.SetTrack(m_join_track, m_join_progress);
+				m_join_progress = TrackProgress();
+				if (m_connection_phase == ConnectionPhase::kJoining)
+				{
+					m_connection_phase = ConnectionPhase::kConnected;
+				}
+			}
+			break;
 		}
 	}
 	break;
@@ -528,11 +755,15 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	case Server::PacketType::AcceptCoopPartner:
 	{
 		sf::Int32 bike_identifier;
-		packet >> bike_identifier;
+		sf::Vector2f bike_position;
+		packet >> bike_identifier >> bike_position.x >> bike_position.y;
 
-		m_world.AddBike(bike_identifier);
-		m_players[bike_identifier].reset(new Player(&m_socket, bike_identifier, GetContext().keys2));
+		Bike* bike = m_world.AddBike(bike_identifier);
+		bike->setPosition(bike_position);
+		bike->SetNetworkDriven(true);
+		m_players[bike_identifier].reset(new Player(m_connection, bike_identifier, GetContext().keys2));
 		m_local_player_identifiers.emplace_back(bike_identifier);
+		m_predicted_bikes.emplace(bike_identifier, PredictedBike(bike_position));
 	}
 	break;
 
@@ -567,19 +798,6 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	}
 	break;
 
-	//New Obstacle to be created
-	case Server::PacketType::SpawnObstacle:
-	{
-		float height;
-		sf::Int32 type;
-		float relative_x;
-		packet >> type >> height >> relative_x;
-
-		m_world.AddObstacle(static_cast<ObstacleType>(type), relative_x, height);
-		m_world.SortObstacles();
-	}
-	break;
-
 	//Mission Successfully completed
 	case Server::PacketType::MissionSuccess:
 	{
@@ -594,7 +812,7 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 	}
 	break;
 
-	//Pickup created
+	//Pickup dropped by an explosion
 	case Server::PacketType::SpawnPickup:
 	{
 		sf::Int32 type;
@@ -607,34 +825,49 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 
 	case Server::PacketType::UpdateClientState:
 	{
-		float current_world_position;
-		sf::Int32 bike_count;
-		packet >> current_world_position >> bike_count;
+		//Rebuild the full state from the baseline the server encoded against
+		WorldSnapshot snapshot;
+		if (!m_snapshot_codec.ReadDelta(packet, m_snapshot_history, snapshot) || snapshot.m_sequence <= m_last_snapshot)
+		{
+			break;
+		}
+		m_snapshot_history.Store(snapshot);
+		m_last_snapshot = snapshot.m_sequence;
 
 		float current_view_position = m_world.GetViewBounds().top + m_world.GetViewBounds().height;
 
 		//Set the world's scroll compensation according to whether the view is behind or ahead
-		m_world.SetWorldScrollCompensation(current_view_position / current_world_position);
+		m_world.SetWorldScrollCompensation(current_view_position / snapshot.m_world_position);
 
-		for (sf::Int32 i = 0; i < bike_count; ++i)
+		//The server is the authority on every bike, including our own
+		std::map<sf::Int32, sf::Vector2f> remote_positions;
+		for (const auto& bike_snapshot : snapshot.m_bikes)
 		{
-			sf::Vector2f bike_position;
-			sf::Int32 bike_identifier;
-			sf::Int32 hitpoints;
-			bool boost;
-
-			packet >> bike_identifier >> bike_position.x >> bike_position.y >> hitpoints >> boost;
+			sf::Int32 bike_identifier = bike_snapshot.first;
 
 			Bike* bike = m_world.GetBike(bike_identifier);
-			bool is_local_bike = std::find(m_local_player_identifiers.begin(), m_local_player_identifiers.end(), bike_identifier) != m_local_player_identifiers.end();
-			if(bike && !is_local_bike)
+			if (!bike)
+			{
+				continue;
+			}
+
+			//Our own bikes are checked against what the server made of the same input, and replayed if they differ.
+			//Remote bikes are buffered and placed each frame in Update
+			auto predicted = m_predicted_bikes.find(bike_identifier);
+			if (predicted != m_predicted_bikes.end())
 			{
-				sf::Vector2f interpolated_position = bike->getPosition() + (bike_position - bike->getPosition()) * 0.1f;
-				bike->setPosition(interpolated_position);
-				bike->SetHitpoints(hitpoints);
-				bike->SetBoost(boost);
+				predicted->second.Reconcile(bike_snapshot.second.m_last_input, m_snapshot_codec.GetMotion(bike_snapshot.second), m_world.GetViewBounds());
+				bike->setPosition(predicted->second.GetMotion().m_position);
 			}
+			else
+			{
+				remote_positions[bike_identifier] = m_snapshot_codec.GetPosition(bike_snapshot.second);
+			}
+			bike->SetHitpoints(bike_snapshot.second.m_hitpoints);
+			bike->SetBoost(bike_snapshot.second.m_boost);
+			bike->SetInvincibility(bike_snapshot.second.m_invincible);
 		}
+		m_snapshot_buffer.Insert(snapshot.m_tick, remote_positions);
 	}
 	break;
 	case Server::PacketType::ServerStart:
@@ -642,11 +875,40 @@ void MultiplayerGameState::HandlePacket(sf::Int32 packet_type, sf::Packet& packe
 		m_in_lobby = false;
 	}
 	break;
+	case Server::PacketType::MatchJoined:
+	{
+		//Nothing on the client depends on which match it is yet, the identifier is only read past
+		sf::Uint32 match_identifier;
+		packet >> match_identifier;
+	}
+	break;
+
 	case Server::PacketType::PlayerCountUpdate:
 		{
 		sf::Int32 player_count;
 		packet >> player_count;
 		m_player_count = player_count;
 		}
+		break;
+
+	//The server times its round trips to us, answer straight away
+	case Server::PacketType::Ping:
+	{
+		sf::Uint32 timestamp;
+		packet >> timestamp;
+
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::Pong>(timestamp);
+		m_connection->Send(message, Delivery::kUnreliableSequenced);
+	}
+	break;
+
+	case Server::PacketType::Pong:
+	{
+		sf::Uint32 timestamp;
+		packet >> timestamp;
+		m_network_statistics.AddRoundTrip(NetworkStatistics::SinceTimestamp(m_ping_clock.getElapsedTime(), timestamp));
+	}
+	break;
 	}
 }
@@ -6,6 +6,13 @@
 #include "GameServer.hpp"
 #include "NetworkProtocol.hpp"
 #include "Button.hpp"
+#include "MessageWriter.hpp"
+#include "NetworkStatistics.hpp"
+#include "SendRateController.hpp"
+#include "Snapshot.hpp"
+#include "PredictedBike.hpp"
+#include "SnapshotBuffer.hpp"
+#include "UdpHost.hpp"
 
 class MultiplayerGameState : public State
 {
@@ -21,7 +28,24 @@ public:
 	void UpdatePlayerCountConnected(sf::Time dt);
 
 private:
+	//Connecting and joining run from Update, so the window keeps drawing and taking input while the server answers
+	enum class ConnectionPhase
+	{
+		//Waiting for the server to accept, the host resends the request with a growing interval
+		kConnecting,
+		//Accepted, waiting for the match's InitialState
+		kJoining,
+		kConnected,
+		//Could not connect or lost the connection, back to the menu after a moment
+		kDisconnected
+	};
+
+private:
+	bool HasConnection() const;
+	void UpdateConnecting();
+	void SetConnectionMessage(const std::string& message);
 	void UpdateBroadcastMessage(sf::Time elapsed_time);
+	void UpdateNetworkStatistics(sf::Time dt);
 	void HandlePacket(sf::Int32 packet_type, sf::Packet& packet);
 
 private:
@@ -34,8 +58,13 @@ private:
 
 	std::map<int, PlayerPtr> m_players;
 	std::vector<sf::Int32> m_local_player_identifiers;
-	sf::TcpSocket m_socket;
-	bool m_connected;
+	std::map<sf::Int32, PredictedBike> m_predicted_bikes;
+	UdpHost m_network_host;
+	//The host's own client talks to its server in process, everyone else over the socket
+	std::unique_ptr<LocalConnection> m_local_connection;
+	Connection* m_connection;
+	ConnectionPhase m_connection_phase;
+	sf::Clock m_connect_clock;
 	std::unique_ptr<GameServer> m_game_server;
 	sf::Clock m_tick_clock;
 
@@ -63,5 +92,28 @@ private:
 	GUI::Container m_in_lobby_ui;
 
 	int m_player_count;
+
+	SnapshotCodec m_snapshot_codec;
+	SnapshotHistory m_snapshot_history;
+	sf::Uint32 m_last_snapshot;
+	SnapshotBuffer m_snapshot_buffer;
+
+	//The track and what the race has used up of it, gathered from the join snapshot before the track is laid out
+	TrackSettings m_join_track;
+	TrackProgress m_join_progress;
+	sf::Uint32 m_join_cursor;
+
+	//Reused for every message sent and received, so the per frame inputs and acks allocate nothing
+	std::vector<char> m_message_buffer;
+	sf::Packet m_receive_packet;
+
+	//Round trip, loss and bandwidth to the server and how far ahead the snapshot buffer is, shown with F3
+	NetworkStatistics m_network_statistics;
+	sf::Clock m_ping_clock;
+	sf::Time m_since_ping;
+	sf::Text m_network_statistics_text;
+	bool m_show_network_statistics;
+	//Inputs are repeated until acknowledged, so on a congested link they can go out every few frames instead
+	SendRateController m_input_rate;
 };
 
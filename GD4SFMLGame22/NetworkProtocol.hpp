@@ -15,14 +15,34 @@ namespace Server
 		PlayerConnect,
 		PlayerDisconnect,
 		AcceptCoopPartner,
+		//Only pickups dropped during the race, the track's own obstacles and pickups are generated by each client
 		SpawnPickup,
-		SpawnObstacle,
 		SpawnSelf,
 		UpdateClientState,
 		MissionSuccess,
 		MissionFail,
 		ServerStart,
-		PlayerCountUpdate
+		PlayerCountUpdate,
+		//Another peer's bike came within or went out of range of this client's own bikes
+		BikeEnterInterest,
+		BikeLeaveInterest,
+		//A dedicated server hosting several matches tells the client which one it was put in
+		MatchJoined,
+		//Carry a millisecond timestamp, a Ping is answered with a Pong echoing it so the sender can time the round trip
+		Ping,
+		Pong,
+		//The state of the match a client joined, a bounded chunk at a time over the ticks after its InitialState
+		JoinSnapshot
+	};
+
+	//What a JoinSnapshot chunk lists. They are sent in this order, each over as many chunks as it takes, and the
+	//last chunk of the track's pickups completes the join
+	enum class JoinSnapshotSection
+	{
+		kBikes,
+		kDroppedPickups,
+		kTrackObstacles,
+		kTrackPickups
 	};
 }
 
@@ -34,11 +54,19 @@ namespace Client
 		PlayerEvent,
 		PlayerRealtimeChange,
 		RequestCoopPartner,
-		PositionUpdate,
+		//Acknowledges the newest snapshot, clients send input rather than positions
+		SnapshotAck,
 		GameEvent,
 		Quit,
 		PauseLobbyUpdate,
-		ClientStart
+		ClientStart,
+		//The most recent sequence numbered input commands for one bike, resent until the server acknowledges them
+		PlayerInput,
+		//First message after connecting, asks for a match by identifier or 0 for any match with room
+		JoinMatch,
+		//The same as the server's Ping and Pong
+		Ping,
+		Pong
 	};
 }
 
@@ -0,0 +1,103 @@
+#include "NetworkStatistics.hpp"
+
+#include <cmath>
+
+namespace
+{
+	const sf::Time kUpdateInterval = sf::seconds(1.f);
+}
+
+const sf::Time NetworkStatistics::kPingInterval = sf::milliseconds(500);
+
+NetworkStatistics::NetworkStatistics()
+	: m_has_round_trip(false)
+	, m_round_trip_time(sf::Time::Zero)
+	, m_last_round_trip(sf::Time::Zero)
+	, m_jitter(sf::Time::Zero)
+	, m_since_update(sf::Time::Zero)
+	, m_loss(0.f)
+	, m_bytes_sent_per_second(0.f)
+	, m_bytes_received_per_second(0.f)
+{
+}
+
+void NetworkStatistics::AddRoundTrip(sf::Time round_trip)
+{
+	if (!m_has_round_trip)
+	{
+		m_has_round_trip = true;
+		m_round_trip_time = round_trip;
+		m_last_round_trip = round_trip;
+		return;
+	}
+
+	//Smoothed the same way UdpConnection smooths its resend timer, one slow Pong should not swing the figure
+	m_round_trip_time = m_round_trip_time * 0.9f + round_trip * 0.1f;
+	sf::Time difference = round_trip > m_last_round_trip ? round_trip - m_last_round_trip : m_last_round_trip - round_trip;
+	m_jitter += (difference - m_jitter) / 16.f;
+	m_last_round_trip = round_trip;
+}
+
+void NetworkStatistics::Update(const ConnectionTraffic& traffic, sf::Time dt)
+{
+	m_since_update += dt;
+	if (m_since_update < kUpdateInterval)
+	{
+		return;
+	}
+
+	float seconds = m_since_update.asSeconds();
+	std::size_t acked = traffic.m_datagrams_acked - m_last_traffic.m_datagrams_acked;
+	std::size_t lost = traffic.m_datagrams_lost - m_last_traffic.m_datagrams_lost;
+	m_loss = (acked + lost) > 0 ? static_cast<float>(lost) / (acked + lost) : 0.f;
+	m_bytes_sent_per_second = (traffic.m_bytes_sent - m_last_traffic.m_bytes_sent) / seconds;
+	m_bytes_received_per_second = (traffic.m_bytes_received - m_last_traffic.m_bytes_received) / seconds;
+
+	m_last_traffic = traffic;
+	m_since_update = sf::Time::Zero;
+}
+
+sf::Uint32 NetworkStatistics::ToTimestamp(sf::Time time)
+{
+	return static_cast<sf::Uint32>(time.asMilliseconds());
+}
+
+sf::Time NetworkStatistics::SinceTimestamp(sf::Time now, sf::Uint32 timestamp)
+{
+	//Unsigned subtraction, so this holds across the clock wrapping
+	return sf::milliseconds(static_cast<sf::Int32>(ToTimestamp(now) - timestamp));
+}
+
+sf::Time NetworkStatistics::GetRoundTripTime() const
+{
+	return m_round_trip_time;
+}
+
+sf::Time NetworkStatistics::GetJitter() const
+{
+	return m_jitter;
+}
+
+float NetworkStatistics::GetLoss() const
+{
+	return m_loss;
+}
+
+float NetworkStatistics::GetBytesSentPerSecond() const
+{
+	return m_bytes_sent_per_second;
+}
+
+float NetworkStatistics::GetBytesReceivedPerSecond() const
+{
+	return m_bytes_received_per_second;
+}
+
+std::string NetworkStatistics::ToString() const
+{
+	return "Round Trip = " + std::to_string(m_round_trip_time.asMilliseconds()) + "ms\n" +
+		"Jitter = " + std::to_string(m_jitter.asMilliseconds()) + "ms\n" +
+		"Loss = " + std::to_string(static_cast<int>(std::round(m_loss * 100.f))) + "%\n" +
+		"Sent = " + std::to_string(static_cast<int>(m_bytes_sent_per_second * 8.f / 1000.f)) + "kbit/s\n" +
+		"Received = " + std::to_string(static_cast<int>(m_bytes_received_per_second * 8.f / 1000.f)) + "kbit/s";
+}
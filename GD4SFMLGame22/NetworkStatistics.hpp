@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "Connection.hpp"
+
+//Latency, jitter, loss and bandwidth of one connection. Round trips come from Ping and Pong messages, timed
+//by whoever sent the Ping; loss and bandwidth are worked out once a second from the connection's running totals
+class NetworkStatistics
+{
+public:
+	static const sf::Time kPingInterval;
+
+public:
+	NetworkStatistics();
+
+	//Jitter is the smoothed difference between consecutive round trips, the way RTP estimates it
+	void AddRoundTrip(sf::Time round_trip);
+	void Update(const ConnectionTraffic& traffic, sf::Time dt);
+	//Milliseconds on a clock that wraps, for the timestamp of a Ping and timing its Pong
+	static sf::Uint32 ToTimestamp(sf::Time time);
+	static sf::Time SinceTimestamp(sf::Time now, sf::Uint32 timestamp);
+
+	sf::Time GetRoundTripTime() const;
+	sf::Time GetJitter() const;
+	//Fraction of the datagrams sent over the last second that were lost
+	float GetLoss() const;
+	float GetBytesSentPerSecond() const;
+	float GetBytesReceivedPerSecond() const;
+	//One line per figure, for an overlay
+	std::string ToString() const;
+
+private:
+	bool m_has_round_trip;
+	sf::Time m_round_trip_time;
+	sf::Time m_last_round_trip;
+	sf::Time m_jitter;
+
+	ConnectionTraffic m_last_traffic;
+	sf::Time m_since_update;
+	float m_loss;
+	float m_bytes_sent_per_second;
+	float m_bytes_received_per_second;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/Graphics/VertexArray.hpp>
+#include <deque>
 
 #include "Particle.hpp"
 #include "SceneNode.hpp"
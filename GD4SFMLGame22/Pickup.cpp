@@ -1,40 +0,0 @@
-#include "Pickup.hpp"
-
-#include <SFML/Graphics/RenderTarget.hpp>
-
-#include "DataTables.hpp"
-#include "ResourceHolder.hpp"
-#include "Utility.hpp"
-
-namespace
-{
-	const std::vector<PickupData> Table = InitializePickupData();
-}
-
-Pickup::Pickup(PickupType type, const TextureHolder& textures)
-	: Entity(1)
-	, m_type(type)
-	, m_sprite(textures.Get(Table[static_cast<int>(type)].m_texture), Table[static_cast<int>(type)].m_texture_rect)
-{
-	Utility::CentreOrigin(m_sprite);
-}
-
-unsigned Pickup::GetCategory() const
-{
-	return Category::Type::kPickup;
-}
-
-sf::FloatRect Pickup::GetBoundingRect() const
-{
-	return GetWorldTransform().transformRect(m_sprite.getGlobalBounds());
-}
-
-void Pickup::Apply(Bike& player) const
-{
-	Table[static_cast<int>(m_type)].m_action(player);
-}
-
-void Pickup::DrawCurrent(sf::RenderTarget& target, sf::RenderStates states) const
-{
-	target.draw(m_sprite, states);
-}
@@ -1,7 +1,7 @@
 #include "Player.hpp"
 #include "Bike.hpp"
+#include "MessageWriter.hpp"
 #include "NetworkProtocol.hpp"
-#include <SFML/Network/Packet.hpp>
 #include <algorithm>
 #include <iostream>
 
@@ -42,11 +42,11 @@ struct BikeBoostTrigger
 	int bike_id;
 };
 
-Player::Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* binding)
+Player::Player(Connection* connection, sf::Int32 identifier, const KeyBinding* binding)
 	: m_key_binding(binding)
 	, m_current_mission_status(MissionStatus::kMissionRunning)
 	, m_identifier(identifier)
-	, m_socket(socket)
+	, m_connection(connection)
 {
 	// Set initial action bindings
 	InitialiseActions();
@@ -67,13 +67,11 @@ void Player::HandleEvent(const sf::Event& event, CommandQueue& commands)
 		if (m_key_binding && m_key_binding->CheckAction(event.key.code, action) && !IsRealtimeAction(action))
 		{
 			// Network connected -> send event over network
-			if (m_socket)
+			if (m_connection)
 			{
-				sf::Packet packet;
-				packet << static_cast<sf::Int32>(Client::PacketType::PlayerEvent);
-				packet << m_identifier;
-				packet << static_cast<sf::Int32>(action);
-				m_socket->send(packet);
+				MessageWriter message(m_message_buffer);
+				message.WriteMessage<ClientMessage::PlayerEvent>(static_cast<sf::Int32>(m_identifier), static_cast<sf::Int32>(action));
+				m_connection->Send(message, Delivery::kReliableOrdered);
 			}
 
 			// Network disconnected -> local event
@@ -85,18 +83,15 @@ void Player::HandleEvent(const sf::Event& event, CommandQueue& commands)
 	}
 
 	// Realtime change (network connected)
-	if ((event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) && m_socket)
+	if ((event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) && m_connection)
 	{
 		PlayerAction action;
 		if (m_key_binding && m_key_binding->CheckAction(event.key.code, action) && IsRealtimeAction(action))
 		{
 			// Send realtime change over network
-			sf::Packet packet;
-			packet << static_cast<sf::Int32>(Client::PacketType::PlayerRealtimeChange);
-			packet << m_identifier;
-			packet << static_cast<sf::Int32>(action);
-			packet << (event.type == sf::Event::KeyPressed);
-			m_socket->send(packet);
+			MessageWriter message(m_message_buffer);
+			message.WriteMessage<ClientMessage::PlayerRealtimeChange>(static_cast<sf::Int32>(m_identifier), static_cast<sf::Int32>(action), event.type == sf::Event::KeyPressed);
+			m_connection->Send(message, Delivery::kReliableOrdered);
 		}
 	}
 }
@@ -111,19 +106,16 @@ void Player::DisableAllRealtimeActions()
 {
 	for(auto & action : m_action_proxies)
 	{
-		sf::Packet packet;
-		packet << static_cast<sf::Int32>(Client::PacketType::PlayerRealtimeChange);
-		packet << m_identifier;
-		packet << static_cast<sf::Int32>(action.first);
-		packet << false;
-		m_socket->send(packet);
+		MessageWriter message(m_message_buffer);
+		message.WriteMessage<ClientMessage::PlayerRealtimeChange>(static_cast<sf::Int32>(m_identifier), static_cast<sf::Int32>(action.first), false);
+		m_connection->Send(message, Delivery::kReliableOrdered);
 	}
 }
 
 void Player::HandleRealtimeInput(CommandQueue& commands)
 {
 	// Check if this is a networked game and local player or just a single player game
-	if ((m_socket && IsLocal()) || !m_socket)
+	if ((m_connection && IsLocal()) || !m_connection)
 	{
 		// Lookup all actions and push corresponding commands to queue
 		std::vector<PlayerAction> activeActions = m_key_binding->GetRealtimeActions();
@@ -132,9 +124,22 @@ void Player::HandleRealtimeInput(CommandQueue& commands)
 	}
 }
 
+InputBits Player::GetRealtimeInput() const
+{
+	InputBits input = 0;
+	if (m_key_binding)
+	{
+		for (PlayerAction action : m_key_binding->GetRealtimeActions())
+		{
+			input |= ToInputBit(action);
+		}
+	}
+	return input;
+}
+
 void Player::HandleRealtimeNetworkInput(CommandQueue& commands)
 {
-	if (m_socket && !IsLocal())
+	if (m_connection && !IsLocal())
 	{
 		// Traverse all realtime input proxies. Because this is a networked game, the input isn't handled directly
 		for(auto pair : m_action_proxies)
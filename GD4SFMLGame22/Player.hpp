@@ -1,20 +1,24 @@
 #pragma once
 #include "Command.hpp"
 #include "KeyBinding.hpp"
-#include <SFML/Network/TcpSocket.hpp>
+#include "Connection.hpp"
 #include <SFML/Window/Event.hpp>
 #include <map>
+#include <vector>
 #include "CommandQueue.hpp"
 #include "MissionStatus.hpp"
 #include "PlayerAction.hpp"
+#include "BikeSimulation.hpp"
 
 class Player
 {
 public:
-	Player(sf::TcpSocket* socket, sf::Int32 identifier, const KeyBinding* binding);
+	Player(Connection* connection, sf::Int32 identifier, const KeyBinding* binding);
 	void HandleEvent(const sf::Event& event, CommandQueue& commands);
 	void HandleRealtimeInput(CommandQueue& commands);
 	void HandleRealtimeNetworkInput(CommandQueue& commands);
+	//The realtime actions currently held, packed the way the server simulates them
+	InputBits GetRealtimeInput() const;
 
 	//React to events or realtime state changes recevied over the network
 	void HandleNetworkEvent(PlayerAction action, CommandQueue& commands);
@@ -36,6 +40,8 @@ private:
 	std::map<PlayerAction, bool> m_action_proxies;
 	MissionStatus m_current_mission_status;
 	int m_identifier;
-	sf::TcpSocket* m_socket;
+	Connection* m_connection;
+	//Reused for every event and realtime change sent
+	std::vector<char> m_message_buffer;
 };
 
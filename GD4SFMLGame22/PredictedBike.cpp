@@ -0,0 +1,116 @@
+#include "PredictedBike.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "MessageWriter.hpp"
+
+namespace
+{
+	//Snapshots quantize positions to a fraction of a pixel and speed to 1/16, differences below this are rounding
+	const float kPositionTolerance = 1.f;
+	const float kSpeedTolerance = 0.5f;
+	//Inputs are resent until acknowledged, but a packet never carries more than this
+	const sf::Uint32 kMaxInputsPerPacket = 16;
+}
+
+PredictedBike::PredictedStep::PredictedStep()
+	: m_sequence(0)
+	, m_input(0)
+	, m_dt(sf::Time::Zero)
+	, m_motion()
+{
+}
+
+PredictedBike::PredictedBike(sf::Vector2f position)
+	: m_history()
+	, m_motion()
+	, m_next_sequence(1)
+	, m_acked_input(0)
+{
+	m_motion.m_position = position;
+}
+
+const BikeMotion& PredictedBike::Step(InputBits input, sf::Time dt, const sf::FloatRect& view)
+{
+	Simulate(m_motion, input, dt, view);
+
+	PredictedStep& step = m_history[m_next_sequence % kHistorySize];
+	step.m_sequence = m_next_sequence;
+	step.m_input = input;
+	step.m_dt = dt;
+	step.m_motion = m_motion;
+	++m_next_sequence;
+
+	return m_motion;
+}
+
+void PredictedBike::Reconcile(sf::Uint32 last_input, const BikeMotion& authoritative, const sf::FloatRect& view)
+{
+	//Nothing to compare against until the server has used one of our inputs, and older snapshots are stale
+	if (last_input == 0 || last_input >= m_next_sequence || last_input < m_acked_input)
+	{
+		return;
+	}
+	m_acked_input = last_input;
+
+	const PredictedStep& step = m_history[last_input % kHistorySize];
+	if (step.m_sequence != last_input)
+	{
+		//Too far behind to replay, take the server's word for it
+		m_motion.m_position = authoritative.m_position;
+		m_motion.m_speed = authoritative.m_speed;
+		m_motion.m_boost = authoritative.m_boost;
+		return;
+	}
+
+	if (Matches(step.m_motion, authoritative))
+	{
+		return;
+	}
+
+	//Mispredicted: rewind to what the server computed for that input and replay everything after it
+	BikeMotion motion = step.m_motion;
+	motion.m_position = authoritative.m_position;
+	motion.m_speed = authoritative.m_speed;
+	motion.m_boost = authoritative.m_boost;
+
+	for (sf::Uint32 sequence = last_input + 1; sequence < m_next_sequence; ++sequence)
+	{
+		PredictedStep& replay = m_history[sequence % kHistorySize];
+		Simulate(motion, replay.m_input, replay.m_dt, view);
+		replay.m_motion = motion;
+	}
+	m_motion = motion;
+}
+
+void PredictedBike::WriteInputs(MessageWriter& message, sf::Int32 identifier) const
+{
+	sf::Uint32 first = std::max(m_acked_input + 1, m_next_sequence - std::min(m_next_sequence - 1, kMaxInputsPerPacket));
+
+	message.WriteMessage<ClientMessage::PlayerInput>(identifier, static_cast<sf::Uint8>(m_next_sequence - first));
+	for (sf::Uint32 sequence = first; sequence < m_next_sequence; ++sequence)
+	{
+		const PredictedStep& step = m_history[sequence % kHistorySize];
+		message << step.m_sequence << step.m_input;
+	}
+}
+
+const BikeMotion& PredictedBike::GetMotion() const
+{
+	return m_motion;
+}
+
+void PredictedBike::Simulate(BikeMotion& motion, InputBits input, sf::Time dt, const sf::FloatRect& view) const
+{
+	StepBike(motion, input, dt);
+	KeepBikeOnScreen(motion, view.left, view.width, view.top + view.height);
+}
+
+bool PredictedBike::Matches(const BikeMotion& predicted, const BikeMotion& authoritative) const
+{
+	return std::abs(predicted.m_position.x - authoritative.m_position.x) < kPositionTolerance
+		&& std::abs(predicted.m_position.y - authoritative.m_position.y) < kPositionTolerance
+		&& std::abs(predicted.m_speed - authoritative.m_speed) < kSpeedTolerance
+		&& predicted.m_boost == authoritative.m_boost;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "BikeSimulation.hpp"
+
+class MessageWriter;
+
+//A local bike run ahead of the server from its player's own input, so it responds without waiting a round trip.
+//Every step is kept with the input it used; when a snapshot shows the server ended up somewhere else, the bike
+//rewinds to the server's state and replays the inputs the server has not processed yet
+class PredictedBike
+{
+public:
+	static const std::size_t kHistorySize = 128;
+
+public:
+	explicit PredictedBike(sf::Vector2f position);
+
+	const BikeMotion& Step(InputBits input, sf::Time dt, const sf::FloatRect& view);
+	void Reconcile(sf::Uint32 last_input, const BikeMotion& authoritative, const sf::FloatRect& view);
+	//Writes a PlayerInput message with every input the server has not acknowledged yet, newest last
+	void WriteInputs(MessageWriter& message, sf::Int32 identifier) const;
+	const BikeMotion& GetMotion() const;
+
+private:
+	struct PredictedStep
+	{
+		PredictedStep();
+		sf::Uint32 m_sequence;
+		InputBits m_input;
+		sf::Time m_dt;
+		BikeMotion m_motion;
+	};
+
+private:
+	void Simulate(BikeMotion& motion, InputBits input, sf::Time dt, const sf::FloatRect& view) const;
+	bool Matches(const BikeMotion& predicted, const BikeMotion& authoritative) const;
+
+private:
+	std::array<PredictedStep, kHistorySize> m_history;
+	BikeMotion m_motion;
+	sf::Uint32 m_next_sequence;
+	sf::Uint32 m_acked_input;
+};
@@ -0,0 +1,65 @@
+#include "RandomStream.hpp"
+
+#include <ctime>
+
+namespace
+{
+	const sf::Uint64 kGoldenGamma = 0x9E3779B97F4A7C15ull;
+
+	//SplitMix64 finalizer, every input bit affects every output bit
+	sf::Uint64 Mix(sf::Uint64 value)
+	{
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+}
+
+RandomStream::RandomStream()
+	: RandomStream(SeedFromClock(), 0)
+{
+}
+
+RandomStream::RandomStream(sf::Uint64 seed, sf::Uint64 stream)
+	: m_key(DeriveSeed(seed, stream))
+	, m_counter(0)
+{
+}
+
+RandomStream::RandomStream(sf::Uint64 seed, RandomStreamId stream)
+	: RandomStream(seed, static_cast<sf::Uint64>(stream))
+{
+}
+
+sf::Uint64 RandomStream::Next()
+{
+	return Mix(m_key + kGoldenGamma * ++m_counter);
+}
+
+int RandomStream::NextInt(int exclusive_max)
+{
+	if (exclusive_max <= 1)
+	{
+		return 0;
+	}
+	//Scale the top 32 bits rather than taking a modulo, cheaper and as good as uniform for ranges this small
+	return static_cast<int>(((Next() >> 32) * static_cast<sf::Uint64>(exclusive_max)) >> 32);
+}
+
+float RandomStream::NextFloat()
+{
+	//24 bits is all a float holds
+	return static_cast<float>(Next() >> 40) / static_cast<float>(1 << 24);
+}
+
+sf::Uint64 RandomStream::DeriveSeed(sf::Uint64 seed, sf::Uint64 stream)
+{
+	return Mix(Mix(seed) ^ (stream * kGoldenGamma + 1));
+}
+
+sf::Uint32 RandomStream::SeedFromClock()
+{
+	//Never 0, which settings use to mean "pick one"
+	sf::Uint32 seed = static_cast<sf::Uint32>(Mix(static_cast<sf::Uint64>(std::time(nullptr))));
+	return seed != 0 ? seed : 1;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <SFML/Config.hpp>
+
+//What a match's random numbers are used for, each gets its own stream off the match seed. Clients are sent the
+//seed so they can reproduce the track stream
+enum class RandomStreamId
+{
+	kTrack,
+	kDrops
+};
+
+//Counter based generator: the nth number of a stream is a hash of the stream's key and n. Streams cost nothing to
+//create and share no state, so every match, thread and purpose can have its own without locking and a match
+//plays out the same from the same seed
+class RandomStream
+{
+public:
+	RandomStream();
+	RandomStream(sf::Uint64 seed, sf::Uint64 stream);
+	RandomStream(sf::Uint64 seed, RandomStreamId stream);
+
+	sf::Uint64 Next();
+	//Uniform in [0, exclusive_max)
+	int NextInt(int exclusive_max);
+	//Uniform in [0, 1)
+	float NextFloat();
+
+	//Mixes a stream number into a seed, e.g. to give each match its own seed off the server's
+	static sf::Uint64 DeriveSeed(sf::Uint64 seed, sf::Uint64 stream);
+	static sf::Uint32 SeedFromClock();
+
+private:
+	sf::Uint64 m_key;
+	sf::Uint64 m_counter;
+};
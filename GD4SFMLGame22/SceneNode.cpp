@@ -2,19 +2,32 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
 #include <iostream>
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 
 #include "Utility.hpp"
 
-SceneNode::SceneNode(Category::Type category):m_children(), m_parent(nullptr), m_default_category(category)
+SceneNode::SceneNode(Category::Type category):m_children(), m_parent(nullptr), m_default_category(category), m_category_index(nullptr), m_world_transform_dirty(true), m_bounding_rect_dirty(true)
 {
 }
 
+void SceneNode::IndexCategories()
+{
+	assert(!m_parent && !m_category_index);
+	m_owned_category_index.reset(new CategoryIndex());
+	Index(m_owned_category_index.get());
+}
+
 void SceneNode::AttachChild(Ptr child)
 {
 	child->m_parent = this;
+	child->MarkTransformDirty();
+	if(m_category_index)
+	{
+		child->Index(m_category_index);
+	}
 	//Todo - Why is emplace_back more efficient than push_back
 	m_children.emplace_back(std::move(child));
 }
@@ -26,6 +39,12 @@ SceneNode::Ptr SceneNode::DetachChild(const SceneNode& node)
 
 	Ptr result = std::move(*found);
 	result->m_parent = nullptr;
+	if(m_category_index)
+	{
+		result->Unindex();
+		m_category_index->RemoveUnindexed();
+	}
+	result->MarkTransformDirty();
 	m_children.erase(found);
 	return result;
 }
@@ -36,19 +55,106 @@ void SceneNode::Update(sf::Time dt, CommandQueue& commands)
 	UpdateChildren(dt, commands);
 }
 
+void SceneNode::setPosition(float x, float y)
+{
+	sf::Transformable::setPosition(x, y);
+	MarkTransformDirty();
+}
+
+void SceneNode::setPosition(const sf::Vector2f& position)
+{
+	sf::Transformable::setPosition(position);
+	MarkTransformDirty();
+}
+
+void SceneNode::setRotation(float angle)
+{
+	sf::Transformable::setRotation(angle);
+	MarkTransformDirty();
+}
+
+void SceneNode::setScale(float factor_x, float factor_y)
+{
+	sf::Transformable::setScale(factor_x, factor_y);
+	MarkTransformDirty();
+}
+
+void SceneNode::setScale(const sf::Vector2f& factors)
+{
+	sf::Transformable::setScale(factors);
+	MarkTransformDirty();
+}
+
+void SceneNode::setOrigin(float x, float y)
+{
+	sf::Transformable::setOrigin(x, y);
+	MarkTransformDirty();
+}
+
+void SceneNode::setOrigin(const sf::Vector2f& origin)
+{
+	sf::Transformable::setOrigin(origin);
+	MarkTransformDirty();
+}
+
+void SceneNode::move(float offset_x, float offset_y)
+{
+	sf::Transformable::move(offset_x, offset_y);
+	MarkTransformDirty();
+}
+
+void SceneNode::move(const sf::Vector2f& offset)
+{
+	sf::Transformable::move(offset);
+	MarkTransformDirty();
+}
+
+void SceneNode::rotate(float angle)
+{
+	sf::Transformable::rotate(angle);
+	MarkTransformDirty();
+}
+
+void SceneNode::scale(float factor_x, float factor_y)
+{
+	sf::Transformable::scale(factor_x, factor_y);
+	MarkTransformDirty();
+}
+
+void SceneNode::scale(const sf::Vector2f& factor)
+{
+	sf::Transformable::scale(factor);
+	MarkTransformDirty();
+}
+
 sf::Vector2f SceneNode::GetWorldPosition() const
 {
 	return GetWorldTransform() * sf::Vector2f();
 }
 
-sf::Transform SceneNode::GetWorldTransform() const
+const sf::Transform& SceneNode::GetWorldTransform() const
 {
-	sf::Transform transform = sf::Transform::Identity;
-	for(const SceneNode* node = this; node != nullptr; node = node->m_parent)
+	if(m_world_transform_dirty)
+	{
+		m_world_transform = m_parent ? m_parent->GetWorldTransform() * getTransform() : getTransform();
+		m_world_transform_dirty = false;
+	}
+	return m_world_transform;
+}
+
+void SceneNode::MarkTransformDirty()
+{
+	m_bounding_rect_dirty = true;
+	if(m_world_transform_dirty)
+	{
+		return;
+	}
+
+	m_world_transform_dirty = true;
+	for(Ptr& child : m_children)
 	{
-		transform = node->getTransform() * transform;
+		child->MarkTransformDirty();
 	}
-	return transform;
 }
 
 void SceneNode::UpdateCurrent(sf::Time dt, CommandQueue& commands)
@@ -91,6 +197,13 @@ void SceneNode::DrawChildren(sf::RenderTarget& target, sf::RenderStates states)
 
 void SceneNode::OnCommand(const Command& command, sf::Time dt)
 {
+	//The root of an indexed scene goes straight to the nodes of the command's categories
+	if(m_owned_category_index)
+	{
+		m_owned_category_index->Dispatch(command, dt);
+		return;
+	}
+
 	//Is this command for me?
 	if(command.category & GetCategory())
 	{
@@ -115,10 +228,25 @@ float Distance(const SceneNode& lhs, const SceneNode& rhs)
 }
 
 sf::FloatRect SceneNode::GetBoundingRect() const
+{
+	if(m_bounding_rect_dirty)
+	{
+		m_bounding_rect = ComputeBoundingRect();
+		m_bounding_rect_dirty = false;
+	}
+	return m_bounding_rect;
+}
+
+sf::FloatRect SceneNode::ComputeBoundingRect() const
 {
 	return sf::FloatRect();
 }
 
+void SceneNode::InvalidateBoundingRect()
+{
+	m_bounding_rect_dirty = true;
+}
+
 void SceneNode::DrawBoundingRect(sf::RenderTarget& target, sf::RenderStates states, sf::FloatRect& rect) const
 {
 	sf::RectangleShape shape;
@@ -135,24 +263,15 @@ bool Collision(const SceneNode& lhs, const SceneNode& rhs)
 	return lhs.GetBoundingRect().intersects(rhs.GetBoundingRect());
 }
 
-void SceneNode::CheckNodeCollision(SceneNode& node, std::set<Pair>& collision_pairs)
+void SceneNode::CollectColliders(unsigned int categories, std::vector<SceneNode*>& colliders)
 {
-	if(this != &node && Collision(*this, node) && !IsDestroyed() && !node.IsDestroyed())
+	if((GetCategory() & categories) && !IsDestroyed())
 	{
-		collision_pairs.insert(std::minmax(this, &node));
+		colliders.emplace_back(this);
 	}
 	for(Ptr& child : m_children)
 	{
-		child->CheckNodeCollision(node, collision_pairs);
-	}
-}
-
-void SceneNode::CheckSceneCollision(SceneNode& scene_graph, std::set<Pair>& collision_pairs)
-{
-	CheckNodeCollision(scene_graph, collision_pairs);
-	for(Ptr& child : scene_graph.m_children)
-	{
-		CheckSceneCollision(*child, collision_pairs);
+		child->CollectColliders(categories, colliders);
 	}
 }
 
@@ -169,7 +288,99 @@ bool SceneNode::IsMarkedForRemoval() const
 
 void SceneNode::RemoveWrecks()
 {
+	//Taken out of the index while they still exist, remove_if destroys them
+	if(m_category_index)
+	{
+		bool any_wrecks = false;
+		for(Ptr& child : m_children)
+		{
+			if(child->IsMarkedForRemoval())
+			{
+				child->Unindex();
+				any_wrecks = true;
+			}
+		}
+		if(any_wrecks)
+		{
+			m_category_index->RemoveUnindexed();
+		}
+	}
+
 	auto wreck_field_begin = std::remove_if(m_children.begin(), m_children.end(), std::mem_fn(&SceneNode::IsMarkedForRemoval));
 	m_children.erase(wreck_field_begin, m_children.end());
 	std::for_each(m_children.begin(), m_children.end(), std::mem_fn(&SceneNode::RemoveWrecks));
 }
+
+void SceneNode::Index(CategoryIndex* index)
+{
+	m_category_index = index;
+	if(GetCategory() != Category::kNone)
+	{
+		index->Add(*this);
+	}
+	for(Ptr& child : m_children)
+	{
+		child->Index(index);
+	}
+}
+
+void SceneNode::Unindex()
+{
+	m_category_index = nullptr;
+	for(Ptr& child : m_children)
+	{
+		child->Unindex();
+	}
+}
+
+SceneNode::CategoryIndex::CategoryIndex()
+	: m_entries()
+{
+}
+
+void SceneNode::CategoryIndex::Add(SceneNode& node)
+{
+	unsigned int category = node.GetCategory();
+	for(std::size_t bit = 0; bit < m_entries.size(); ++bit)
+	{
+		if(category & (1u << bit))
+		{
+			m_entries[bit].emplace_back(Entry{ &node, category });
+		}
+	}
+}
+
+void SceneNode::CategoryIndex::RemoveUnindexed()
+{
+	for(std::vector<Entry>& entries : m_entries)
+	{
+		auto unindexed_begin = std::remove_if(entries.begin(), entries.end(), [this](const Entry& entry) {return entry.m_node->m_category_index != this; });
+		entries.erase(unindexed_begin, entries.end());
+	}
+}
+
+void SceneNode::CategoryIndex::Dispatch(const Command& command, sf::Time dt)
+{
+	unsigned int visited_categories = 0;
+	for(std::size_t bit = 0; bit < m_entries.size(); ++bit)
+	{
+		unsigned int category = 1u << bit;
+		if(!(command.category & category))
+		{
+			continue;
+		}
+
+		//By index and only up to the nodes there were, an action may attach more
+		std::vector<Entry>& entries = m_entries[bit];
+		std::size_t count = entries.size();
+		for(std::size_t i = 0; i < count && i < entries.size(); ++i)
+		{
+			//A node of several of the command's categories was visited under the first of them
+			if(!(entries[i].m_category & visited_categories))
+			{
+				command.action(*entries[i].m_node, dt);
+			}
+		}
+		visited_categories |= category;
+	}
+}
@@ -4,9 +4,10 @@
 #include <SFML/Graphics/Transformable.hpp>
 #include <SFML/Graphics/Drawable.hpp>
 
+#include <array>
+#include <climits>
 #include <vector>
 #include <memory>
-#include <set>
 
 #include "Command.hpp"
 #include "CommandQueue.hpp"
@@ -19,22 +20,66 @@ public:
 
 public:
 	explicit SceneNode(Category::Type category = Category::kNone);
+	//Makes this node the root of an indexed scene, commands given to it then visit only the nodes they are for.
+	//A node's GetCategory must not change while it is in an indexed scene
+	void IndexCategories();
 	void AttachChild(Ptr child);
 	Ptr DetachChild(const SceneNode& node);
 
 	void Update(sf::Time dt, CommandQueue& commands);
 
+	//These hide sf::Transformable's own, so that moving a node marks it and everything below it as moved
+	void setPosition(float x, float y);
+	void setPosition(const sf::Vector2f& position);
+	void setRotation(float angle);
+	void setScale(float factor_x, float factor_y);
+	void setScale(const sf::Vector2f& factors);
+	void setOrigin(float x, float y);
+	void setOrigin(const sf::Vector2f& origin);
+	void move(float offset_x, float offset_y);
+	void move(const sf::Vector2f& offset);
+	void rotate(float angle);
+	void scale(float factor_x, float factor_y);
+	void scale(const sf::Vector2f& factor);
+
+	//Both are worked out again only after the node or one of its ancestors has moved
 	sf::Vector2f GetWorldPosition() const;
-	sf::Transform GetWorldTransform() const;
+	const sf::Transform& GetWorldTransform() const;
 
 	void OnCommand(const Command& command, sf::Time dt);
 	virtual unsigned int GetCategory() const;
-	virtual sf::FloatRect GetBoundingRect() const;
+	sf::FloatRect GetBoundingRect() const;
 
-	void CheckSceneCollision(SceneNode& scene_graph, std::set<Pair>& collision_pairs);
+	//Appends this node and its descendants that are of one of the categories and not destroyed
+	void CollectColliders(unsigned int categories, std::vector<SceneNode*>& colliders);
 	void RemoveWrecks();
 
 
+protected:
+	//For nodes whose bounds change other than by moving, e.g. a new texture rect on their sprite
+	void InvalidateBoundingRect();
+
+private:
+	//Per category bit, the nodes of the indexed scene that have it, in the order they were attached
+	class CategoryIndex
+	{
+	public:
+		CategoryIndex();
+		void Add(SceneNode& node);
+		//Drops the nodes that no longer point at this index, before they are destroyed
+		void RemoveUnindexed();
+		void Dispatch(const Command& command, sf::Time dt);
+
+	private:
+		struct Entry
+		{
+			SceneNode* m_node;
+			unsigned int m_category;
+		};
+
+		std::array<std::vector<Entry>, sizeof(unsigned int) * CHAR_BIT> m_entries;
+	};
+
 private:
 	virtual void UpdateCurrent(sf::Time dt, CommandQueue& commands);
 	void UpdateChildren(sf::Time dt, CommandQueue& commands);
@@ -48,14 +93,26 @@ private:
 
 	virtual bool IsDestroyed() const;
 	virtual bool IsMarkedForRemoval() const;
-	
-	void CheckNodeCollision(SceneNode& node, std::set<Pair>& collisionPairs);
-	
+	//Bounds in world coordinates, GetBoundingRect caches them. Empty for nodes that take no part in collisions
+	virtual sf::FloatRect ComputeBoundingRect() const;
+	void MarkTransformDirty();
+	void Index(CategoryIndex* index);
+	void Unindex();
+
 
 private:
 	std::vector<Ptr> m_children;
 	SceneNode* m_parent;
 	Category::Type m_default_category;
+	//Every node of an indexed scene points at the index its root owns
+	CategoryIndex* m_category_index;
+	std::unique_ptr<CategoryIndex> m_owned_category_index;
+
+	//A dirty node's descendants are all dirty too, so marking can stop at one that already is
+	mutable sf::Transform m_world_transform;
+	mutable bool m_world_transform_dirty;
+	mutable sf::FloatRect m_bounding_rect;
+	mutable bool m_bounding_rect_dirty;
 };
 bool Collision(const SceneNode& lhs, const SceneNode& rhs);
 float Distance(const SceneNode& lhs, const SceneNode& rhs);
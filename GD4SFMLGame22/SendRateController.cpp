@@ -0,0 +1,114 @@
+#include "SendRateController.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	//The budget can save up at most this much time's worth of bytes, so an idle peer does not get a burst later
+	const sf::Time kMaxBurst = sf::milliseconds(250);
+	//NetworkStatistics works out loss once a second, decisions are made as often
+	const sf::Time kEvaluationInterval = sf::seconds(1.f);
+	const std::size_t kEvaluationsBeforeRecovery = 3;
+	const float kMaxLoss = 0.05f;
+	//A round trip this much above the best seen means packets are queuing somewhere on the way
+	const float kRoundTripGrowth = 2.f;
+	const sf::Time kRoundTripSlack = sf::milliseconds(50);
+	const float kMinInterestScale = 0.5f;
+	const float kInterestBackOff = 0.75f;
+	const float kInterestRecovery = 0.125f;
+}
+
+SendRateController::SendRateController(std::size_t max_interval, float bytes_per_second)
+	: m_max_interval(std::max<std::size_t>(max_interval, 1))
+	, m_bytes_per_second(bytes_per_second)
+	, m_budget(bytes_per_second * kMaxBurst.asSeconds())
+	, m_over_budget(false)
+	, m_interval(1)
+	, m_since_send(0)
+	, m_interest_scale(1.f)
+	, m_best_round_trip(sf::Time::Zero)
+	, m_since_evaluation(sf::Time::Zero)
+	, m_clear_evaluations(0)
+{
+}
+
+bool SendRateController::ShouldSend(sf::Time dt)
+{
+	if (m_bytes_per_second > 0.f)
+	{
+		m_budget = std::min(m_budget + m_bytes_per_second * dt.asSeconds(), m_bytes_per_second * kMaxBurst.asSeconds());
+	}
+
+	if (++m_since_send < m_interval)
+	{
+		return false;
+	}
+
+	//Wait for the budget to refill, the next send carries everything that changed in the meantime
+	if (m_bytes_per_second > 0.f && m_budget < 0.f)
+	{
+		m_over_budget = true;
+		return false;
+	}
+
+	m_since_send = 0;
+	return true;
+}
+
+void SendRateController::OnSent(std::size_t bytes)
+{
+	if (m_bytes_per_second > 0.f)
+	{
+		m_budget -= static_cast<float>(bytes);
+	}
+}
+
+void SendRateController::Update(const NetworkStatistics& statistics, sf::Time dt)
+{
+	sf::Time round_trip = statistics.GetRoundTripTime();
+	if (round_trip > sf::Time::Zero && (m_best_round_trip == sf::Time::Zero || round_trip < m_best_round_trip))
+	{
+		m_best_round_trip = round_trip;
+	}
+
+	m_since_evaluation += dt;
+	if (m_since_evaluation < kEvaluationInterval)
+	{
+		return;
+	}
+	m_since_evaluation = sf::Time::Zero;
+
+	bool queuing = m_best_round_trip > sf::Time::Zero && round_trip > m_best_round_trip * kRoundTripGrowth + kRoundTripSlack;
+	bool congested = m_over_budget || queuing || statistics.GetLoss() > kMaxLoss;
+	m_over_budget = false;
+
+	//Back off fast and recover slowly, so a link on the edge does not oscillate
+	if (congested)
+	{
+		m_interval = std::min(m_interval * 2, m_max_interval);
+		m_interest_scale = std::max(m_interest_scale * kInterestBackOff, kMinInterestScale);
+		m_clear_evaluations = 0;
+	}
+	else if (++m_clear_evaluations >= kEvaluationsBeforeRecovery)
+	{
+		if (m_interval > 1)
+		{
+			--m_interval;
+		}
+		else
+		{
+			m_interest_scale = std::min(m_interest_scale + kInterestRecovery, 1.f);
+		}
+		m_clear_evaluations = 0;
+	}
+}
+
+std::size_t SendRateController::GetInterval() const
+{
+	return m_interval;
+}
+
+float SendRateController::GetInterestScale() const
+{
+	return m_interest_scale;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+
+#include <SFML/System/Time.hpp>
+
+#include "NetworkStatistics.hpp"
+
+//Decides which of a stream of regular send opportunities, e.g. server ticks, are used for one peer. Sends are held
+//back while they would exceed the peer's byte budget, and the interval between sends doubles when the link shows
+//loss or a round trip growing past its best. Once the link has been clear for a while the interval comes back down
+//one step at a time. The area of interest shrinks and grows with it, so a saturated peer hears about nearby bikes first
+class SendRateController
+{
+public:
+	//A budget of 0 bytes per second is unlimited
+	SendRateController(std::size_t max_interval, float bytes_per_second);
+
+	//Called once per send opportunity, returns whether this one is used
+	bool ShouldSend(sf::Time dt);
+	void OnSent(std::size_t bytes);
+	void Update(const NetworkStatistics& statistics, sf::Time dt);
+
+	//Send opportunities per send, 1 is every one
+	std::size_t GetInterval() const;
+	float GetInterestScale() const;
+
+private:
+	std::size_t m_max_interval;
+	float m_bytes_per_second;
+	//Token bucket, bytes that may be sent now. Goes negative when a send overshoots
+	float m_budget;
+	bool m_over_budget;
+
+	std::size_t m_interval;
+	std::size_t m_since_send;
+	float m_interest_scale;
+
+	sf::Time m_best_round_trip;
+	sf::Time m_since_evaluation;
+	std::size_t m_clear_evaluations;
+};
@@ -0,0 +1,329 @@
+#include "ServerWorld.hpp"
+
+#include <algorithm>
+
+#include "BikeType.hpp"
+#include "SimulationData.hpp"
+
+namespace
+{
+	const std::vector<BikeSimulationData> BikeTable = InitializeBikeSimulationData();
+	const std::vector<ObstacleSimulationData> ObstacleTable = InitializeObstacleSimulationData();
+	const std::vector<PickupSimulationData> PickupTable = InitializePickupSimulationData();
+
+	//The same numbers World, Bike and Pickup use on the client. Counters count fixed 60Hz steps
+	const float kScrollSpeed = 200.f;
+	const float kBattlefieldMargin = 250.f;
+	const float kRemovalDistance = 400.f;
+	const sf::Int32 kObstacleDamage = 10;
+	const unsigned int kInvincibleDuration = 100;
+
+	//A client further ahead than this has its oldest inputs dropped, so its latency cannot build up
+	const std::size_t kMaxQueuedInputs = 8;
+	const unsigned int kMaxInputDebt = 8;
+
+	const BikeSimulationData& Racer()
+	{
+		return BikeTable[static_cast<int>(BikeType::kRacer)];
+	}
+}
+
+ServerWorld::BikeState::BikeState()
+	: m_motion()
+	, m_hitpoints(Racer().m_hitpoints)
+	, m_invincible(false)
+	, m_invincible_counter(0)
+	, m_is_host(false)
+	, m_inputs()
+	, m_input(0)
+	, m_last_input(0)
+	, m_last_queued_input(0)
+	, m_input_debt(0)
+{
+}
+
+ServerWorld::ServerWorld(sf::Vector2f view_size, float battlefield_bottom)
+	: m_view_size(view_size)
+	, m_view_left(0.f)
+	, m_battlefield_bottom(battlefield_bottom)
+	, m_tick(0)
+	, m_entity_identifier_counter(1)
+{
+}
+
+void ServerWorld::Update(sf::Time dt, float scroll_compensation)
+{
+	++m_tick;
+
+	//Scroll the view the clients are looking through
+	m_view_left += kScrollSpeed * dt.asSeconds() * scroll_compensation;
+
+	DestroyEntitiesOutsideView();
+	HandleCollisions();
+
+	for (auto& pair : m_bikes)
+	{
+		BikeState& bike = pair.second;
+		if (bike.m_hitpoints <= 0 || bike.m_hitpoints == kDeadHostHitpoints)
+		{
+			continue;
+		}
+
+		ConsumeInput(bike);
+		UpdateInvincibility(bike);
+		StepBike(bike.m_motion, bike.m_input, dt);
+		KeepBikeOnScreen(bike.m_motion, m_view_left, m_view_size.x, m_battlefield_bottom);
+	}
+}
+
+ServerWorld::BikeState& ServerWorld::AddBike(sf::Int32 identifier, sf::Vector2f position)
+{
+	BikeState& bike = m_bikes[identifier];
+	bike = BikeState();
+	bike.m_motion.m_position = position;
+	//The first bike is the host's, as in Bike::UpdateRollAnimation
+	bike.m_is_host = identifier == 1;
+	return bike;
+}
+
+void ServerWorld::RemoveBike(sf::Int32 identifier)
+{
+	m_bikes.erase(identifier);
+}
+
+void ServerWorld::RemoveDestroyedBikes()
+{
+	for (auto itr = m_bikes.begin(); itr != m_bikes.end();)
+	{
+		if (itr->second.m_hitpoints <= 0)
+		{
+			itr = m_bikes.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+ServerWorld::BikeState* ServerWorld::GetBike(sf::Int32 identifier)
+{
+	auto itr = m_bikes.find(identifier);
+	return itr != m_bikes.end() ? &itr->second : nullptr;
+}
+
+const ServerWorld::BikeState* ServerWorld::GetBike(sf::Int32 identifier) const
+{
+	auto itr = m_bikes.find(identifier);
+	return itr != m_bikes.end() ? &itr->second : nullptr;
+}
+
+const std::map<sf::Int32, ServerWorld::BikeState>& ServerWorld::GetBikes() const
+{
+	return m_bikes;
+}
+
+sf::Uint32 ServerWorld::GetTick() const
+{
+	return m_tick;
+}
+
+float ServerWorld::GetViewLeft() const
+{
+	return m_view_left;
+}
+
+void ServerWorld::AddObstacle(ObstacleType type, sf::Vector2f position, sf::Uint32 track_index)
+{
+	m_obstacles.push_back(ObstacleState{ m_entity_identifier_counter++, type, position, track_index });
+}
+
+void ServerWorld::AddPickup(PickupType type, sf::Vector2f position)
+{
+	m_pickups.push_back(PickupState{ m_entity_identifier_counter++, type, position, false, 0 });
+}
+
+void ServerWorld::AddTrackPickup(PickupType type, sf::Vector2f position, sf::Uint32 track_index)
+{
+	m_pickups.push_back(PickupState{ m_entity_identifier_counter++, type, position, true, track_index });
+}
+
+const std::vector<ServerWorld::ObstacleState>& ServerWorld::GetObstacles() const
+{
+	return m_obstacles;
+}
+
+const std::vector<ServerWorld::PickupState>& ServerWorld::GetPickups() const
+{
+	return m_pickups;
+}
+
+void ServerWorld::QueueInput(sf::Int32 identifier, const InputCommand& command)
+{
+	//Clients resend recent inputs with every packet, only take the ones not seen yet
+	BikeState* bike = GetBike(identifier);
+	if (bike && command.m_sequence > bike->m_last_queued_input)
+	{
+		bike->m_inputs.push_back(command);
+		bike->m_last_queued_input = command.m_sequence;
+	}
+}
+
+void ServerWorld::ConsumeInput(BikeState& bike) const
+{
+	auto take_input = [&bike]()
+	{
+		bike.m_input = bike.m_inputs.front().m_input;
+		bike.m_last_input = bike.m_inputs.front().m_sequence;
+		bike.m_inputs.pop_front();
+	};
+
+	while (!bike.m_inputs.empty() && (bike.m_input_debt > 0 || bike.m_inputs.size() > kMaxQueuedInputs))
+	{
+		take_input();
+		if (bike.m_input_debt > 0)
+		{
+			--bike.m_input_debt;
+		}
+	}
+
+	if (!bike.m_inputs.empty())
+	{
+		take_input();
+	}
+	else if (bike.m_last_input != 0 && bike.m_input_debt < kMaxInputDebt)
+	{
+		//Nothing arrived in time, keep doing what the player was doing
+		++bike.m_input_debt;
+	}
+}
+
+void ServerWorld::UpdateInvincibility(BikeState& bike) const
+{
+	if (bike.m_invincible_counter > 0 || bike.m_invincible)
+	{
+		bike.m_invincible_counter++;
+	}
+	if (bike.m_invincible_counter > kInvincibleDuration)
+	{
+		bike.m_invincible = false;
+		bike.m_invincible_counter = 0;
+	}
+}
+
+void ServerWorld::HandleCollisions()
+{
+	for (auto first = m_bikes.begin(); first != m_bikes.end(); ++first)
+	{
+		BikeState& bike = first->second;
+		if (bike.m_hitpoints <= 0 || bike.m_hitpoints == kDeadHostHitpoints)
+		{
+			continue;
+		}
+		Bounds bike_bounds = GetBikeBounds(bike);
+
+		//An invincible bike destroys any other bike it touches
+		for (auto second = std::next(first); second != m_bikes.end(); ++second)
+		{
+			BikeState& other = second->second;
+			if (other.m_hitpoints <= 0 || other.m_hitpoints == kDeadHostHitpoints || !Overlaps(bike_bounds, GetBikeBounds(other)))
+			{
+				continue;
+			}
+
+			if (bike.m_invincible)
+				other.m_hitpoints = 0;
+			else if (other.m_invincible)
+				bike.m_hitpoints = 0;
+		}
+
+		for (auto itr = m_pickups.begin(); itr != m_pickups.end();)
+		{
+			if (Overlaps(bike_bounds, GetBounds(itr->m_position, PickupTable[static_cast<int>(itr->m_type)].m_size)))
+			{
+				if (itr->m_type == PickupType::kInvincible)
+				{
+					bike.m_invincible = true;
+					bike.m_invincible_counter = 1;
+				}
+				else
+				{
+					bike.m_motion.m_boost = true;
+				}
+				itr = m_pickups.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+
+		for (auto itr = m_obstacles.begin(); itr != m_obstacles.end();)
+		{
+			const ObstacleSimulationData& data = ObstacleTable[static_cast<int>(itr->m_type)];
+			if (Overlaps(bike_bounds, GetBounds(itr->m_position, data.m_size)))
+			{
+				if (!bike.m_invincible)
+				{
+					bike.m_motion.m_speed = std::max(bike.m_motion.m_speed - bike.m_motion.m_speed * data.m_slow_down_amount, 0.f);
+					bike.m_hitpoints -= kObstacleDamage;
+				}
+				itr = m_obstacles.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+}
+
+void ServerWorld::DestroyEntitiesOutsideView()
+{
+	//Anything entirely behind the left edge of the battlefield is gone, except the host who is parked as dead
+	float battlefield_left = m_view_left - kBattlefieldMargin;
+	for (auto& pair : m_bikes)
+	{
+		BikeState& bike = pair.second;
+		if (bike.m_hitpoints <= 0 || GetBikeBounds(bike).m_max.x >= battlefield_left)
+		{
+			continue;
+		}
+
+		if (bike.m_is_host)
+		{
+			bike.m_hitpoints = kDeadHostHitpoints;
+			bike.m_motion.m_speed = 0.f;
+		}
+		else
+		{
+			bike.m_hitpoints = 0;
+		}
+	}
+
+	m_obstacles.erase(std::remove_if(m_obstacles.begin(), m_obstacles.end(), [battlefield_left](const ObstacleState& obstacle)
+	{
+		return obstacle.m_position.x < battlefield_left - kRemovalDistance;
+	}), m_obstacles.end());
+
+	m_pickups.erase(std::remove_if(m_pickups.begin(), m_pickups.end(), [battlefield_left](const PickupState& pickup)
+	{
+		return pickup.m_position.x < battlefield_left - kRemovalDistance;
+	}), m_pickups.end());
+}
+
+ServerWorld::Bounds ServerWorld::GetBikeBounds(const BikeState& bike) const
+{
+	return GetBounds(bike.m_motion.m_position, Racer().m_size);
+}
+
+ServerWorld::Bounds ServerWorld::GetBounds(sf::Vector2f position, sf::Vector2f size) const
+{
+	//Sprites are centred on their position
+	return Bounds{ position - size / 2.f, position + size / 2.f };
+}
+
+bool ServerWorld::Overlaps(const Bounds& lhs, const Bounds& rhs)
+{
+	return lhs.m_min.x < rhs.m_max.x && rhs.m_min.x < lhs.m_max.x && lhs.m_min.y < rhs.m_max.y && rhs.m_min.y < lhs.m_max.y;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <vector>
+#include <SFML/Config.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "BikeSimulation.hpp"
+#include "ObstacleType.hpp"
+#include "PickupType.hpp"
+
+//Graphics-free simulation of the race that the server runs at a fixed step and is the authority on.
+//Mirrors what Bike, Obstacle, Pickup and World do on the client: bike motion from the players' input commands,
+//keeping bikes on screen, obstacle slowdown and damage, pickups and invincibility
+class ServerWorld
+{
+public:
+	//Hitpoints the host's bike is parked on once it falls off screen, the same marker Bike uses on the client
+	static const sf::Int32 kDeadHostHitpoints = 22;
+
+	struct BikeState
+	{
+		BikeState();
+		BikeMotion m_motion;
+		sf::Int32 m_hitpoints;
+		bool m_invincible;
+		unsigned int m_invincible_counter;
+		bool m_is_host;
+
+		//Input commands received but not yet simulated, one is used per step
+		std::deque<InputCommand> m_inputs;
+		InputBits m_input;
+		sf::Uint32 m_last_input;
+		sf::Uint32 m_last_queued_input;
+		//Steps simulated with a repeated input because none had arrived, later inputs are skipped to catch up
+		unsigned int m_input_debt;
+	};
+
+	//Obstacles and pickups never move, identifiers let the server remember which peers have been told about them
+	struct ObstacleState
+	{
+		sf::Uint32 m_identifier;
+		ObstacleType m_type;
+		sf::Vector2f m_position;
+		//Where the track generated it, see TrackGenerator::ObstacleSpawn
+		sf::Uint32 m_track_index;
+	};
+
+	struct PickupState
+	{
+		sf::Uint32 m_identifier;
+		PickupType m_type;
+		sf::Vector2f m_position;
+		//Part of the generated track, which clients lay out themselves, rather than dropped during the race
+		bool m_on_track;
+		sf::Uint32 m_track_index;
+	};
+
+public:
+	ServerWorld(sf::Vector2f view_size, float battlefield_bottom);
+	void Update(sf::Time dt, float scroll_compensation);
+
+	BikeState& AddBike(sf::Int32 identifier, sf::Vector2f position);
+	void RemoveBike(sf::Int32 identifier);
+	void RemoveDestroyedBikes();
+	BikeState* GetBike(sf::Int32 identifier);
+	const BikeState* GetBike(sf::Int32 identifier) const;
+	const std::map<sf::Int32, BikeState>& GetBikes() const;
+
+	void AddObstacle(ObstacleType type, sf::Vector2f position, sf::Uint32 track_index);
+	void AddPickup(PickupType type, sf::Vector2f position);
+	void AddTrackPickup(PickupType type, sf::Vector2f position, sf::Uint32 track_index);
+	const std::vector<ObstacleState>& GetObstacles() const;
+	const std::vector<PickupState>& GetPickups() const;
+	void QueueInput(sf::Int32 identifier, const InputCommand& command);
+	//Number of fixed steps simulated so far, snapshots are stamped with it
+	sf::Uint32 GetTick() const;
+	//Left edge of the view the clients are looking through
+	float GetViewLeft() const;
+
+private:
+	void ConsumeInput(BikeState& bike) const;
+	void UpdateInvincibility(BikeState& bike) const;
+	void HandleCollisions();
+	void DestroyEntitiesOutsideView();
+	//Corners of an axis aligned box, sf::FloatRect would pull the graphics module into the server
+	struct Bounds
+	{
+		sf::Vector2f m_min;
+		sf::Vector2f m_max;
+	};
+
+	Bounds GetBikeBounds(const BikeState& bike) const;
+	Bounds GetBounds(sf::Vector2f position, sf::Vector2f size) const;
+	//Touching edges do not count, the same as sf::FloatRect::intersects
+	static bool Overlaps(const Bounds& lhs, const Bounds& rhs);
+
+private:
+	sf::Vector2f m_view_size;
+	float m_view_left;
+	float m_battlefield_bottom;
+	sf::Uint32 m_tick;
+	sf::Uint32 m_entity_identifier_counter;
+
+	std::map<sf::Int32, BikeState> m_bikes;
+	std::vector<ObstacleState> m_obstacles;
+	std::vector<PickupState> m_pickups;
+};
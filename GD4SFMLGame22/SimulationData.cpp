@@ -0,0 +1,40 @@
+#include "SimulationData.hpp"
+#include "BikeType.hpp"
+#include "ObstacleType.hpp"
+#include "PickupType.hpp"
+
+std::vector<BikeSimulationData> InitializeBikeSimulationData()
+{
+	std::vector<BikeSimulationData> data(static_cast<int>(BikeType::kBikeCount));
+
+	data[static_cast<int>(BikeType::kRacer)].m_hitpoints = 100;
+	data[static_cast<int>(BikeType::kRacer)].m_max_speed = 450.f;
+	data[static_cast<int>(BikeType::kRacer)].m_size = sf::Vector2f(57.f, 29.f);
+
+	return data;
+}
+
+std::vector<ObstacleSimulationData> InitializeObstacleSimulationData()
+{
+	std::vector<ObstacleSimulationData> data(static_cast<int>(ObstacleType::kObstacleCount));
+
+	data[static_cast<int>(ObstacleType::kTarSpill)].m_slow_down_amount = 0.4f;
+	data[static_cast<int>(ObstacleType::kTarSpill)].m_size = sf::Vector2f(45.f, 19.f);
+
+	data[static_cast<int>(ObstacleType::kAcidSpill)].m_slow_down_amount = 0.2f;
+	data[static_cast<int>(ObstacleType::kAcidSpill)].m_size = sf::Vector2f(45.f, 19.f);
+
+	data[static_cast<int>(ObstacleType::kBarrier)].m_slow_down_amount = 0.9f;
+	data[static_cast<int>(ObstacleType::kBarrier)].m_size = sf::Vector2f(17.f, 29.f);
+	return data;
+}
+
+std::vector<PickupSimulationData> InitializePickupSimulationData()
+{
+	std::vector<PickupSimulationData> data(static_cast<int>(PickupType::kPickupCount));
+
+	data[static_cast<int>(PickupType::kInvincible)].m_size = sf::Vector2f(40.f, 40.f);
+	data[static_cast<int>(PickupType::kBoostRefill)].m_size = sf::Vector2f(40.f, 40.f);
+
+	return data;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <SFML/System/Vector2.hpp>
+
+//Gameplay values shared by the client's DataTables and the server's ServerWorld. Kept free of textures and
+//scene nodes so the dedicated server can use them without linking the graphics module
+//Sizes match the texture rects the sprites are drawn with, they are what collisions are tested against
+
+struct BikeSimulationData
+{
+	int m_hitpoints;
+	float m_max_speed;
+	sf::Vector2f m_size;
+};
+
+struct ObstacleSimulationData
+{
+	float m_slow_down_amount;
+	sf::Vector2f m_size;
+};
+
+struct PickupSimulationData
+{
+	sf::Vector2f m_size;
+};
+
+std::vector<BikeSimulationData> InitializeBikeSimulationData();
+std::vector<ObstacleSimulationData> InitializeObstacleSimulationData();
+std::vector<PickupSimulationData> InitializePickupSimulationData();
@@ -0,0 +1,323 @@
+#include "Snapshot.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <SFML/Network/Packet.hpp>
+
+#include "MessageWriter.hpp"
+
+namespace
+{
+	//Bits of the per-bike field mask, the boost and invincible values travel in the mask itself
+	enum SnapshotField
+	{
+		kPositionX = 1 << 0,
+		kPositionY = 1 << 1,
+		kHitpoints = 1 << 2,
+		kBoost = 1 << 3,
+		kBoostValue = 1 << 4,
+		kInvincible = 1 << 5,
+		kInvincibleValue = 1 << 6,
+		kMotion = 1 << 7,
+		kAllFields = kPositionX | kPositionY | kHitpoints | kBoost | kInvincible | kMotion
+	};
+
+	//Bikes are allowed some distance outside the track before they are destroyed
+	const float kTrackMargin = 512.f;
+	const float kQuantizeSteps = 65535.f;
+	const float kSpeedScale = 16.f;
+
+	sf::Uint8 ChangedFields(const WorldSnapshot* baseline, sf::Int32 identifier, const BikeSnapshot& bike)
+	{
+		if (!baseline)
+		{
+			return kAllFields;
+		}
+
+		const BikeSnapshot* old_bike = baseline->FindBike(identifier);
+		if (!old_bike)
+		{
+			return kAllFields;
+		}
+
+		const BikeSnapshot& old_state = *old_bike;
+		sf::Uint8 mask = 0;
+		if (old_state.m_x != bike.m_x)
+			mask |= kPositionX;
+		if (old_state.m_y != bike.m_y)
+			mask |= kPositionY;
+		if (old_state.m_hitpoints != bike.m_hitpoints)
+			mask |= kHitpoints;
+		if (old_state.m_boost != bike.m_boost)
+			mask |= kBoost;
+		if (old_state.m_invincible != bike.m_invincible)
+			mask |= kInvincible;
+		if (old_state.m_speed != bike.m_speed || old_state.m_last_input != bike.m_last_input)
+			mask |= kMotion;
+		return mask;
+	}
+
+	bool IdentifierLess(const std::pair<sf::Int32, BikeSnapshot>& bike, sf::Int32 identifier)
+	{
+		return bike.first < identifier;
+	}
+}
+
+BikeSnapshot::BikeSnapshot()
+	: m_x(0)
+	, m_y(0)
+	, m_hitpoints(0)
+	, m_boost(false)
+	, m_invincible(false)
+	, m_speed(0)
+	, m_last_input(0)
+{
+}
+
+WorldSnapshot::WorldSnapshot()
+	: m_sequence(0)
+	, m_tick(0)
+	, m_world_position(0.f)
+	, m_bikes()
+{
+}
+
+const BikeSnapshot* WorldSnapshot::FindBike(sf::Int32 identifier) const
+{
+	auto itr = std::lower_bound(m_bikes.begin(), m_bikes.end(), identifier, IdentifierLess);
+	if (itr == m_bikes.end() || itr->first != identifier)
+	{
+		return nullptr;
+	}
+	return &itr->second;
+}
+
+BikeSnapshot& WorldSnapshot::GetOrAddBike(sf::Int32 identifier)
+{
+	auto itr = std::lower_bound(m_bikes.begin(), m_bikes.end(), identifier, IdentifierLess);
+	if (itr == m_bikes.end() || itr->first != identifier)
+	{
+		itr = m_bikes.emplace(itr, identifier, BikeSnapshot());
+	}
+	return itr->second;
+}
+
+void WorldSnapshot::RemoveBike(sf::Int32 identifier)
+{
+	auto itr = std::lower_bound(m_bikes.begin(), m_bikes.end(), identifier, IdentifierLess);
+	if (itr != m_bikes.end() && itr->first == identifier)
+	{
+		m_bikes.erase(itr);
+	}
+}
+
+void SnapshotHistory::Store(const WorldSnapshot& snapshot)
+{
+	m_snapshots[snapshot.m_sequence % kSize] = snapshot;
+}
+
+WorldSnapshot& SnapshotHistory::Begin(sf::Uint32 sequence)
+{
+	WorldSnapshot& snapshot = m_snapshots[sequence % kSize];
+	snapshot.m_sequence = sequence;
+	snapshot.m_bikes.clear();
+	return snapshot;
+}
+
+void SnapshotHistory::Reserve(std::size_t bike_count)
+{
+	for (WorldSnapshot& snapshot : m_snapshots)
+	{
+		snapshot.m_bikes.reserve(bike_count);
+	}
+}
+
+const WorldSnapshot* SnapshotHistory::Find(sf::Uint32 sequence) const
+{
+	//Sequence 0 is never used, it means "no baseline"
+	const WorldSnapshot& snapshot = m_snapshots[sequence % kSize];
+	if (sequence == 0 || snapshot.m_sequence != sequence)
+	{
+		return nullptr;
+	}
+	return &snapshot;
+}
+
+SnapshotCodec::SnapshotCodec(sf::Vector2f world_size)
+	: m_min(-kTrackMargin, 0.f)
+	, m_range(world_size.x + 2.f * kTrackMargin, world_size.y)
+{
+}
+
+BikeSnapshot SnapshotCodec::Capture(const BikeMotion& motion, sf::Int32 hitpoints, bool invincible, sf::Uint32 last_input) const
+{
+	BikeSnapshot bike;
+	bike.m_x = Quantize(motion.m_position.x, m_min.x, m_range.x);
+	bike.m_y = Quantize(motion.m_position.y, m_min.y, m_range.y);
+	bike.m_hitpoints = static_cast<sf::Int16>(hitpoints);
+	bike.m_boost = motion.m_boost;
+	bike.m_invincible = invincible;
+	bike.m_speed = static_cast<sf::Uint16>(std::min(std::max(motion.m_speed * kSpeedScale, 0.f), kQuantizeSteps));
+	bike.m_last_input = last_input;
+	return bike;
+}
+
+sf::Vector2f SnapshotCodec::GetPosition(const BikeSnapshot& bike) const
+{
+	return sf::Vector2f(Dequantize(bike.m_x, m_min.x, m_range.x), Dequantize(bike.m_y, m_min.y, m_range.y));
+}
+
+BikeMotion SnapshotCodec::GetMotion(const BikeSnapshot& bike) const
+{
+	BikeMotion motion;
+	motion.m_position = GetPosition(bike);
+	motion.m_speed = static_cast<float>(bike.m_speed) / kSpeedScale;
+	motion.m_boost = bike.m_boost;
+	return motion;
+}
+
+void SnapshotCodec::WriteDelta(MessageWriter& message, const WorldSnapshot* baseline, const WorldSnapshot& current) const
+{
+	message << current.m_sequence;
+	message << (baseline ? baseline->m_sequence : static_cast<sf::Uint32>(0));
+	message << current.m_tick;
+	message << current.m_world_position;
+
+	//Count first so the client knows how many entries to read
+	sf::Uint16 changed_count = 0;
+	for (const auto& bike : current.m_bikes)
+	{
+		if (ChangedFields(baseline, bike.first, bike.second) != 0)
+		{
+			++changed_count;
+		}
+	}
+
+	message << changed_count;
+	for (const auto& bike : current.m_bikes)
+	{
+		sf::Uint8 mask = ChangedFields(baseline, bike.first, bike.second);
+		if (mask == 0)
+		{
+			continue;
+		}
+
+		if (bike.second.m_boost)
+		{
+			mask |= kBoostValue;
+		}
+		if (bike.second.m_invincible)
+		{
+			mask |= kInvincibleValue;
+		}
+
+		message << static_cast<sf::Uint16>(bike.first) << mask;
+		if (mask & kPositionX)
+			message << bike.second.m_x;
+		if (mask & kPositionY)
+			message << bike.second.m_y;
+		if (mask & kHitpoints)
+			message << bike.second.m_hitpoints;
+		if (mask & kMotion)
+			message << bike.second.m_speed << bike.second.m_last_input;
+	}
+
+	//Bikes that were in the baseline but are gone now
+	if (baseline)
+	{
+		sf::Uint16 removed_count = 0;
+		for (const auto& bike : baseline->m_bikes)
+		{
+			if (!current.FindBike(bike.first))
+			{
+				++removed_count;
+			}
+		}
+
+		message << removed_count;
+		for (const auto& bike : baseline->m_bikes)
+		{
+			if (!current.FindBike(bike.first))
+			{
+				message << static_cast<sf::Uint16>(bike.first);
+			}
+		}
+	}
+	else
+	{
+		message << static_cast<sf::Uint16>(0);
+	}
+}
+
+bool SnapshotCodec::ReadDelta(sf::Packet& packet, const SnapshotHistory& history, WorldSnapshot& out) const
+{
+	sf::Uint32 sequence;
+	sf::Uint32 baseline_sequence;
+	sf::Uint32 tick;
+	float world_position;
+	packet >> sequence >> baseline_sequence >> tick >> world_position;
+
+	if (baseline_sequence != 0)
+	{
+		const WorldSnapshot* baseline = history.Find(baseline_sequence);
+		if (!baseline)
+		{
+			return false;
+		}
+		out = *baseline;
+	}
+	else
+	{
+		out = WorldSnapshot();
+	}
+
+	out.m_sequence = sequence;
+	out.m_tick = tick;
+	out.m_world_position = world_position;
+
+	sf::Uint16 changed_count;
+	packet >> changed_count;
+	for (sf::Uint16 i = 0; i < changed_count; ++i)
+	{
+		sf::Uint16 identifier;
+		sf::Uint8 mask;
+		packet >> identifier >> mask;
+
+		BikeSnapshot& bike = out.GetOrAddBike(identifier);
+		if (mask & kPositionX)
+			packet >> bike.m_x;
+		if (mask & kPositionY)
+			packet >> bike.m_y;
+		if (mask & kHitpoints)
+			packet >> bike.m_hitpoints;
+		if (mask & kMotion)
+			packet >> bike.m_speed >> bike.m_last_input;
+		if (mask & kBoost)
+			bike.m_boost = (mask & kBoostValue) != 0;
+		if (mask & kInvincible)
+			bike.m_invincible = (mask & kInvincibleValue) != 0;
+	}
+
+	sf::Uint16 removed_count;
+	packet >> removed_count;
+	for (sf::Uint16 i = 0; i < removed_count; ++i)
+	{
+		sf::Uint16 identifier;
+		packet >> identifier;
+		out.RemoveBike(identifier);
+	}
+
+	return static_cast<bool>(packet);
+}
+
+sf::Uint16 SnapshotCodec::Quantize(float value, float min, float range) const
+{
+	float normalised = std::min(std::max((value - min) / range, 0.f), 1.f);
+	return static_cast<sf::Uint16>(std::lround(normalised * kQuantizeSteps));
+}
+
+float SnapshotCodec::Dequantize(sf::Uint16 value, float min, float range) const
+{
+	return min + (static_cast<float>(value) / kQuantizeSteps) * range;
+}
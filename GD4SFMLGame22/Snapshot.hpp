@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <utility>
+#include <vector>
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "BikeSimulation.hpp"
+
+namespace sf
+{
+	class Packet;
+}
+
+class MessageWriter;
+
+//State of one bike as carried in an UpdateClientState snapshot. Positions are quantized to 16 bits
+//across the battlefield, so the baseline the server deltas against is exactly what the client decoded
+struct BikeSnapshot
+{
+	BikeSnapshot();
+	sf::Uint16 m_x;
+	sf::Uint16 m_y;
+	sf::Int16 m_hitpoints;
+	bool m_boost;
+	bool m_invincible;
+	//Speed in 1/16 pixels per second, and the last input command the server applied to this bike.
+	//Together with the position this is what a client needs to replay its own unacknowledged inputs
+	sf::Uint16 m_speed;
+	sf::Uint32 m_last_input;
+};
+
+struct WorldSnapshot
+{
+	WorldSnapshot();
+	//Null if the snapshot does not have the bike
+	const BikeSnapshot* FindBike(sf::Int32 identifier) const;
+	//Adds the bike in identifier order if the snapshot does not have it yet
+	BikeSnapshot& GetOrAddBike(sf::Int32 identifier);
+	void RemoveBike(sf::Int32 identifier);
+
+	sf::Uint32 m_sequence;
+	//Server simulation step the snapshot was taken at, clients interpolate remote bikes on this timeline
+	sf::Uint32 m_tick;
+	float m_world_position;
+	//In identifier order. A vector rather than a map, so refilling a snapshot or copying one over another reuses
+	//the storage it already has instead of allocating a node per bike
+	std::vector<std::pair<sf::Int32, BikeSnapshot>> m_bikes;
+};
+
+//The last few snapshots sent (server) or decoded (client), looked up by sequence number to use as delta baselines
+class SnapshotHistory
+{
+public:
+	static const std::size_t kSize = 32;
+
+public:
+	void Store(const WorldSnapshot& snapshot);
+	//Empties the slot the snapshot with this sequence goes in and returns it to be filled in place, keeping the
+	//storage the slot had. Only invalidates the snapshot kSize sequences older
+	WorldSnapshot& Begin(sf::Uint32 sequence);
+	const WorldSnapshot* Find(sf::Uint32 sequence) const;
+	void Reserve(std::size_t bike_count);
+
+private:
+	std::array<WorldSnapshot, kSize> m_snapshots;
+};
+
+class SnapshotCodec
+{
+public:
+	explicit SnapshotCodec(sf::Vector2f world_size = sf::Vector2f(12000.f, 1017.f));
+
+	BikeSnapshot Capture(const BikeMotion& motion, sf::Int32 hitpoints, bool invincible, sf::Uint32 last_input) const;
+	sf::Vector2f GetPosition(const BikeSnapshot& bike) const;
+	BikeMotion GetMotion(const BikeSnapshot& bike) const;
+
+	//Writes only what changed since the baseline, or every field when there is no baseline
+	void WriteDelta(MessageWriter& message, const WorldSnapshot* baseline, const WorldSnapshot& current) const;
+	//Returns false if the baseline the packet was encoded against is no longer in the history
+	bool ReadDelta(sf::Packet& packet, const SnapshotHistory& history, WorldSnapshot& out) const;
+
+private:
+	sf::Uint16 Quantize(float value, float min, float range) const;
+	float Dequantize(sf::Uint16 value, float min, float range) const;
+
+private:
+	sf::Vector2f m_min;
+	sf::Vector2f m_range;
+};
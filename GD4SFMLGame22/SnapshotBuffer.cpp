@@ -0,0 +1,159 @@
+#include "SnapshotBuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "BikeSimulation.hpp"
+
+namespace
+{
+	//Render this many snapshot intervals behind the newest snapshot, so one lost or late packet still leaves a pair to interpolate
+	const float kInterpolationIntervals = 2.f;
+	//Carry a bike on for at most 100ms past its newest snapshot, then hold it there
+	const float kMaxExtrapolationTicks = 6.f;
+	//Further off than this and the render clock jumps instead of drifting back
+	const float kMaxClockError = 30.f;
+	const float kMaxClockAdjustment = 0.1f;
+	const float kClockCorrection = 0.01f;
+	const float kIntervalSmoothing = 0.1f;
+
+	sf::Vector2f Lerp(sf::Vector2f from, sf::Vector2f to, float t)
+	{
+		return from + (to - from) * t;
+	}
+}
+
+SnapshotBuffer::SnapshotBuffer()
+	: m_snapshots()
+	, m_render_tick(0.f)
+	, m_time_scale(1.f)
+	, m_snapshot_interval(0.f)
+{
+}
+
+void SnapshotBuffer::Insert(sf::Uint32 tick, const std::map<sf::Int32, sf::Vector2f>& positions)
+{
+	if (!m_snapshots.empty())
+	{
+		sf::Uint32 newest_tick = m_snapshots.back().m_tick;
+		//Out of order or from a server step that has already been buffered
+		if (tick <= newest_tick)
+		{
+			return;
+		}
+
+		float interval = static_cast<float>(tick - newest_tick);
+		m_snapshot_interval = m_snapshot_interval == 0.f ? interval : m_snapshot_interval + (interval - m_snapshot_interval) * kIntervalSmoothing;
+	}
+
+	m_snapshots.push_back(TimedPositions{ tick, positions });
+	if (m_snapshots.size() > kCapacity)
+	{
+		m_snapshots.pop_front();
+	}
+
+	//Steer the render clock towards the delay behind this snapshot
+	float error = (static_cast<float>(tick) - GetDelay()) - m_render_tick;
+	if (m_snapshots.size() == 1 || std::abs(error) > kMaxClockError)
+	{
+		m_render_tick = static_cast<float>(tick) - GetDelay();
+		m_time_scale = 1.f;
+	}
+	else
+	{
+		m_time_scale = 1.f + std::max(-kMaxClockAdjustment, std::min(kMaxClockAdjustment, error * kClockCorrection));
+	}
+}
+
+void SnapshotBuffer::Advance(sf::Time dt)
+{
+	if (!m_snapshots.empty())
+	{
+		m_render_tick += dt / kSimulationStep * m_time_scale;
+	}
+}
+
+bool SnapshotBuffer::Sample(sf::Int32 identifier, sf::Vector2f& position, sf::Vector2f& velocity) const
+{
+	//Find the snapshots with this bike on either side of the render tick, and the one before for extrapolating
+	const TimedPositions* previous = nullptr;
+	const TimedPositions* before = nullptr;
+	const TimedPositions* after = nullptr;
+	for (const TimedPositions& snapshot : m_snapshots)
+	{
+		if (snapshot.m_positions.count(identifier) == 0)
+		{
+			continue;
+		}
+		if (static_cast<float>(snapshot.m_tick) <= m_render_tick)
+		{
+			previous = before;
+			before = &snapshot;
+		}
+		else
+		{
+			after = &snapshot;
+			break;
+		}
+	}
+
+	const float step = kSimulationStep.asSeconds();
+	if (before && after)
+	{
+		sf::Vector2f from = before->m_positions.at(identifier);
+		sf::Vector2f to = after->m_positions.at(identifier);
+		float ticks = static_cast<float>(after->m_tick - before->m_tick);
+
+		position = Lerp(from, to, (m_render_tick - before->m_tick) / ticks);
+		velocity = (to - from) / (ticks * step);
+	}
+	else if (before)
+	{
+		//Late packets: continue the last known motion for a little while, then hold
+		position = before->m_positions.at(identifier);
+		velocity = sf::Vector2f();
+		if (previous)
+		{
+			float late_ticks = m_render_tick - before->m_tick;
+			velocity = (position - previous->m_positions.at(identifier)) / (static_cast<float>(before->m_tick - previous->m_tick) * step);
+			position += velocity * std::min(late_ticks, kMaxExtrapolationTicks) * step;
+			if (late_ticks >= kMaxExtrapolationTicks)
+			{
+				velocity = sf::Vector2f();
+			}
+		}
+	}
+	else if (after)
+	{
+		//The bike only appears after the render tick, show it where it first was
+		position = after->m_positions.at(identifier);
+		velocity = sf::Vector2f();
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+std::size_t SnapshotBuffer::GetDepth() const
+{
+	return std::count_if(m_snapshots.begin(), m_snapshots.end(), [this](const TimedPositions& snapshot)
+	{
+		return static_cast<float>(snapshot.m_tick) > m_render_tick;
+	});
+}
+
+sf::Time SnapshotBuffer::GetBufferedTime() const
+{
+	if (m_snapshots.empty())
+	{
+		return sf::Time::Zero;
+	}
+	return kSimulationStep * (static_cast<float>(m_snapshots.back().m_tick) - m_render_tick);
+}
+
+float SnapshotBuffer::GetDelay() const
+{
+	return kInterpolationIntervals * m_snapshot_interval;
+}
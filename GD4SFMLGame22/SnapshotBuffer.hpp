@@ -0,0 +1,45 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <SFML/Config.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Vector2.hpp>
+
+//Recent server positions of remote bikes, stamped with the server tick they were taken at.
+//Remote bikes are drawn a couple of snapshot intervals in the past, between the two snapshots around that moment,
+//so their motion is smooth however packets arrive. When packets are late the last motion is carried on for a short while
+class SnapshotBuffer
+{
+public:
+	static const std::size_t kCapacity = 32;
+
+public:
+	SnapshotBuffer();
+
+	void Insert(sf::Uint32 tick, const std::map<sf::Int32, sf::Vector2f>& positions);
+	void Advance(sf::Time dt);
+	//Returns false if the bike is in none of the buffered snapshots
+	bool Sample(sf::Int32 identifier, sf::Vector2f& position, sf::Vector2f& velocity) const;
+	//Snapshots not yet reached by the render clock, and how far the newest is ahead of it
+	std::size_t GetDepth() const;
+	sf::Time GetBufferedTime() const;
+
+private:
+	struct TimedPositions
+	{
+		sf::Uint32 m_tick;
+		std::map<sf::Int32, sf::Vector2f> m_positions;
+	};
+
+private:
+	float GetDelay() const;
+
+private:
+	std::deque<TimedPositions> m_snapshots;
+	//Server tick currently being drawn, fractional between snapshots
+	float m_render_tick;
+	//Speeds up or slows down the render clock slightly to keep it the interpolation delay behind the newest snapshot
+	float m_time_scale;
+	//Smoothed number of ticks between snapshots
+	float m_snapshot_interval;
+};
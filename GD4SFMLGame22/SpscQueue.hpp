@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <SFML/System/NonCopyable.hpp>
+
+//Fixed size ring buffer between exactly one producer thread and one consumer thread, with no locks. Slots are
+//filled and read in place, so a slot holding e.g. a std::vector keeps its capacity and, once every slot has grown
+//to fit, passing messages through allocates nothing
+template <typename T>
+class SpscQueue : private sf::NonCopyable
+{
+public:
+	//Rounded up to a power of two
+	explicit SpscQueue(std::size_t capacity);
+
+	//Producer: the slot to fill next, or nullptr when the queue is full. Push makes it visible to the consumer
+	T* GetFreeSlot();
+	void Push();
+
+	//Consumer: the oldest slot pushed, or nullptr when the queue is empty. Pop hands it back to the producer
+	T* GetFront();
+	void Pop();
+
+private:
+	std::vector<T> m_slots;
+	std::size_t m_mask;
+	//Each index is only written by one side. They are kept on separate cache lines so the two threads do not
+	//keep taking the line from each other
+	std::atomic<std::size_t> m_head;
+	char m_padding[64];
+	std::atomic<std::size_t> m_tail;
+};
+
+#include "SpscQueue.inl"
@@ -0,0 +1,50 @@
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity)
+	: m_mask(0)
+	, m_head(0)
+	, m_tail(0)
+{
+	std::size_t size = 1;
+	while (size < capacity)
+	{
+		size *= 2;
+	}
+	m_slots.resize(size);
+	m_mask = size - 1;
+}
+
+template <typename T>
+T* SpscQueue<T>::GetFreeSlot()
+{
+	//The consumer's index is acquired so the slot is not written before it has finished reading it
+	std::size_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+	{
+		return nullptr;
+	}
+	return &m_slots[tail & m_mask];
+}
+
+template <typename T>
+void SpscQueue<T>::Push()
+{
+	//Released so the consumer sees the slot's contents once it sees the new index
+	m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T>
+T* SpscQueue<T>::GetFront()
+{
+	std::size_t head = m_head.load(std::memory_order_relaxed);
+	if (head == m_tail.load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+	return &m_slots[head & m_mask];
+}
+
+template <typename T>
+void SpscQueue<T>::Pop()
+{
+	m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,32 @@
+#include "SweepAndPrune.hpp"
+
+#include <algorithm>
+
+void SweepAndPrune::FindPairs(const std::vector<SceneNode*>& colliders, std::vector<SceneNode::Pair>& pairs)
+{
+	pairs.clear();
+	m_entries.clear();
+	for (SceneNode* node : colliders)
+	{
+		m_entries.push_back(Entry{ node->GetBoundingRect(), node });
+	}
+
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry& lhs, const Entry& rhs)
+		{
+			return lhs.m_bounds.left < rhs.m_bounds.left;
+		});
+
+	//Everything after an entry that starts before it ends overlaps it along x, the first that starts after ends the sweep
+	for (std::size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const Entry& entry = m_entries[i];
+		float right = entry.m_bounds.left + entry.m_bounds.width;
+		for (std::size_t j = i + 1; j < m_entries.size() && m_entries[j].m_bounds.left < right; ++j)
+		{
+			if (entry.m_bounds.intersects(m_entries[j].m_bounds))
+			{
+				pairs.emplace_back(std::minmax(entry.m_node, m_entries[j].m_node));
+			}
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include "SceneNode.hpp"
+
+//Broad phase collision detection for a side scroller. Colliders are sorted along x by the left edge of their bounds
+//and each is only tested against those that start before it ends, so the cost grows with n log n plus the number of
+//overlaps along x rather than with every pair. Bounds are worked out once per collider per call
+class SweepAndPrune
+{
+public:
+	//Replaces the contents of pairs with every pair of colliders whose bounding rectangles intersect, each pair once
+	void FindPairs(const std::vector<SceneNode*>& colliders, std::vector<SceneNode::Pair>& pairs);
+
+private:
+	struct Entry
+	{
+		sf::FloatRect m_bounds;
+		SceneNode* m_node;
+	};
+
+private:
+	//Reused from call to call so finding pairs does not allocate once it has grown
+	std::vector<Entry> m_entries;
+};
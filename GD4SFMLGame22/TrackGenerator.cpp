@@ -0,0 +1,131 @@
+#include "TrackGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "RandomStream.hpp"
+
+namespace
+{
+	const float kSegmentLength = 500.f;
+	//Bikes get a clear run from the start, and the last stretch before the finish line is left empty
+	const float kStartClearance = 800.f;
+	const float kFinishClearance = 1500.f;
+	//Obstacles and pickups sit on the road, between the barrier at the top and the bottom of the screen
+	const float kRoadTop = 650.f;
+	const float kRoadHeight = 350.f;
+	const float kPickupTop = 750.f;
+	const float kPickupHeight = 200.f;
+	//Chances per segment
+	const float kBoostRefillChance = 0.5f;
+	const float kInvincibleChance = 0.125f;
+
+	//Numbers the spawns a segment added and drops those the progress has as used up
+	template <typename Spawn>
+	void NumberSpawns(std::vector<Spawn>& spawns, std::size_t first, sf::Uint32& count, sf::Uint32 used_count, const std::vector<sf::Uint32>& live)
+	{
+		for (std::size_t i = first; i < spawns.size(); ++i)
+		{
+			spawns[i].m_index = count++;
+		}
+		spawns.erase(std::remove_if(spawns.begin() + first, spawns.end(), [used_count, &live](const Spawn& spawn)
+			{
+				return spawn.m_index < used_count && !std::binary_search(live.begin(), live.end(), spawn.m_index);
+			}), spawns.end());
+	}
+}
+
+TrackSettings::TrackSettings()
+	: m_seed(1)
+	, m_difficulty(1.f)
+	, m_length(12000.f)
+{
+}
+
+TrackProgress::TrackProgress()
+	: m_obstacle_count(0)
+	, m_pickup_count(0)
+{
+}
+
+TrackGenerator::TrackGenerator(const TrackSettings& settings, const TrackProgress& progress)
+	: m_settings(settings)
+	, m_progress(progress)
+	, m_track_seed(RandomStream::DeriveSeed(settings.m_seed, static_cast<sf::Uint64>(RandomStreamId::kTrack)))
+	, m_next_segment(0)
+	, m_obstacle_count(0)
+	, m_pickup_count(0)
+{
+}
+
+void TrackGenerator::GenerateUntil(float x, std::vector<ObstacleSpawn>& obstacles, std::vector<PickupSpawn>& pickups)
+{
+	float end = std::min(x, m_settings.m_length - kFinishClearance);
+	while (m_next_segment * kSegmentLength < end)
+	{
+		std::size_t first_obstacle = obstacles.size();
+		std::size_t first_pickup = pickups.size();
+		GenerateSegment(m_next_segment++, obstacles, pickups);
+		NumberSpawns(obstacles, first_obstacle, m_obstacle_count, m_progress.m_obstacle_count, m_progress.m_live_obstacles);
+		NumberSpawns(pickups, first_pickup, m_pickup_count, m_progress.m_pickup_count, m_progress.m_live_pickups);
+	}
+}
+
+const TrackSettings& TrackGenerator::GetSettings() const
+{
+	return m_settings;
+}
+
+sf::Uint32 TrackGenerator::GetObstacleCount() const
+{
+	return m_obstacle_count;
+}
+
+sf::Uint32 TrackGenerator::GetPickupCount() const
+{
+	return m_pickup_count;
+}
+
+void TrackGenerator::GenerateSegment(sf::Uint32 segment, std::vector<ObstacleSpawn>& obstacles, std::vector<PickupSpawn>& pickups) const
+{
+	float left = segment * kSegmentLength;
+	if (left < kStartClearance)
+	{
+		return;
+	}
+
+	//A segment's contents only depend on the seed and its number, never on what was generated before it
+	RandomStream random(m_track_seed, segment);
+
+	//One or two obstacles per segment on the standard race, the fraction left over by the difficulty is a chance of one more
+	float obstacle_count = (1 + random.NextInt(2)) * std::max(m_settings.m_difficulty, 0.f) + random.NextFloat();
+	std::size_t first_obstacle = obstacles.size();
+	for (int i = 0; i < static_cast<int>(std::floor(obstacle_count)); ++i)
+	{
+		ObstacleType type = static_cast<ObstacleType>(random.NextInt(static_cast<int>(ObstacleType::kObstacleCount)));
+		sf::Vector2f position(left + random.NextFloat() * kSegmentLength, kRoadTop + random.NextFloat() * kRoadHeight);
+		obstacles.push_back(ObstacleSpawn{ type, position, 0 });
+	}
+
+	std::size_t first_pickup = pickups.size();
+	if (random.NextFloat() < kBoostRefillChance)
+	{
+		sf::Vector2f position(left + random.NextFloat() * kSegmentLength, kPickupTop + random.NextFloat() * kPickupHeight);
+		pickups.push_back(PickupSpawn{ PickupType::kBoostRefill, position, 0 });
+	}
+	if (random.NextFloat() < kInvincibleChance)
+	{
+		sf::Vector2f position(left + random.NextFloat() * kSegmentLength, kPickupTop + random.NextFloat() * kPickupHeight);
+		pickups.push_back(PickupSpawn{ PickupType::kInvincible, position, 0 });
+	}
+
+	//Segments come out in order, so sorting within this one keeps the whole list sorted
+	std::sort(obstacles.begin() + first_obstacle, obstacles.end(), [](const ObstacleSpawn& lhs, const ObstacleSpawn& rhs)
+		{
+			return lhs.m_position.x < rhs.m_position.x;
+		});
+	std::sort(pickups.begin() + first_pickup, pickups.end(), [](const PickupSpawn& lhs, const PickupSpawn& rhs)
+		{
+			return lhs.m_position.x < rhs.m_position.x;
+		});
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "ObstacleType.hpp"
+#include "PickupType.hpp"
+
+//Everything that decides a race's layout. The server sends these to its clients when they join
+struct TrackSettings
+{
+	TrackSettings();
+	sf::Uint32 m_seed;
+	//Scales how many obstacles each stretch of track gets, 1 is the standard race
+	float m_difficulty;
+	float m_length;
+};
+
+//How far a race has got through its track, for a client joining part way. Of the first m_obstacle_count obstacles
+//and m_pickup_count pickups the track generates, only those whose indices are listed are still there
+struct TrackProgress
+{
+	TrackProgress();
+	sf::Uint32 m_obstacle_count;
+	sf::Uint32 m_pickup_count;
+	//Ascending
+	std::vector<sf::Uint32> m_live_obstacles;
+	std::vector<sf::Uint32> m_live_pickups;
+};
+
+//Lays out a race's obstacles and pickups from its settings. The server and every client run one with the same
+//settings and get the same track, so none of it is sent. The track is made one fixed length segment at a time,
+//each from its own random stream, as the race gets to it, so memory does not grow with the length of the track
+class TrackGenerator
+{
+public:
+	//Indices count obstacles and pickups separately in the order they are generated, the same everywhere
+	struct ObstacleSpawn
+	{
+		ObstacleType m_type;
+		sf::Vector2f m_position;
+		sf::Uint32 m_index;
+	};
+
+	struct PickupSpawn
+	{
+		PickupType m_type;
+		sf::Vector2f m_position;
+		sf::Uint32 m_index;
+	};
+
+public:
+	//Whatever the progress says is used up is left out as it is generated
+	explicit TrackGenerator(const TrackSettings& settings, const TrackProgress& progress = TrackProgress());
+	//Appends everything up to x that has not been generated yet, in order along the track
+	void GenerateUntil(float x, std::vector<ObstacleSpawn>& obstacles, std::vector<PickupSpawn>& pickups);
+	const TrackSettings& GetSettings() const;
+	//Obstacles and pickups generated so far, also the indices the next ones get
+	sf::Uint32 GetObstacleCount() const;
+	sf::Uint32 GetPickupCount() const;
+
+private:
+	void GenerateSegment(sf::Uint32 segment, std::vector<ObstacleSpawn>& obstacles, std::vector<PickupSpawn>& pickups) const;
+
+private:
+	TrackSettings m_settings;
+	TrackProgress m_progress;
+	sf::Uint64 m_track_seed;
+	sf::Uint32 m_next_segment;
+	sf::Uint32 m_obstacle_count;
+	sf::Uint32 m_pickup_count;
+};
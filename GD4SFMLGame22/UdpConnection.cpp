@@ -0,0 +1,533 @@
+#include "UdpConnection.hpp"
+
+#include <algorithm>
+
+#include "UdpHost.hpp"
+
+//Datagram layout after the UdpHost header (protocol id, type):
+//	Uint16 sequence, Uint16 ack, Uint32 ack bits, Uint8 flags, Uint8 message count
+//	then per message: Uint8 delivery, Uint16 message sequence, Uint16 size, size bytes of sf::Packet data
+//All integers are in network byte order
+
+namespace
+{
+	const std::size_t kDataHeaderSize = 10;
+	//Set once anything has been received, until then the ack fields mean nothing
+	const sf::Uint8 kAckValid = 1 << 0;
+	const std::size_t kMessageHeaderSize = 5;
+	const sf::Time kKeepAliveInterval = sf::milliseconds(100);
+	const sf::Time kMinimumResendTimeout = sf::milliseconds(200);
+	//Both ends send at least every kKeepAliveInterval, so a datagram unacknowledged for this long is not coming back
+	const sf::Time kLossTimeout = sf::seconds(1.f);
+	//A message has to fit in one datagram on its own, and its size has to fit the Uint16 size field
+	const std::size_t kMaxMessageSize = std::min<std::size_t>(UdpHost::kMaxDatagramPayload - kDataHeaderSize - kMessageHeaderSize, 0xFFFF);
+	//Reliable messages unacknowledged or waiting on an earlier one. A peer that falls this far behind or
+	//sends this far ahead is not coming back, and queueing more for it only grows memory
+	const std::size_t kMaxPendingReliable = 1024;
+
+	void WriteUint8(std::vector<char>& buffer, sf::Uint8 value)
+	{
+		buffer.push_back(static_cast<char>(value));
+	}
+
+	void WriteUint16(std::vector<char>& buffer, sf::Uint16 value)
+	{
+		buffer.push_back(static_cast<char>(value >> 8));
+		buffer.push_back(static_cast<char>(value & 0xFF));
+	}
+
+	void WriteUint32(std::vector<char>& buffer, sf::Uint32 value)
+	{
+		WriteUint16(buffer, static_cast<sf::Uint16>(value >> 16));
+		WriteUint16(buffer, static_cast<sf::Uint16>(value & 0xFFFF));
+	}
+
+	bool ReadUint8(const char*& cursor, const char* end, sf::Uint8& value)
+	{
+		if (end - cursor < 1)
+			return false;
+		value = static_cast<sf::Uint8>(cursor[0]);
+		cursor += 1;
+		return true;
+	}
+
+	bool ReadUint16(const char*& cursor, const char* end, sf::Uint16& value)
+	{
+		if (end - cursor < 2)
+			return false;
+		value = static_cast<sf::Uint16>((static_cast<sf::Uint8>(cursor[0]) << 8) | static_cast<sf::Uint8>(cursor[1]));
+		cursor += 2;
+		return true;
+	}
+
+	bool ReadUint32(const char*& cursor, const char* end, sf::Uint32& value)
+	{
+		sf::Uint16 high, low;
+		if (!ReadUint16(cursor, end, high) || !ReadUint16(cursor, end, low))
+			return false;
+		value = (static_cast<sf::Uint32>(high) << 16) | low;
+		return true;
+	}
+
+	//Sequence numbers wrap around, so "newer" means less than half the range ahead
+	bool SequenceGreaterThan(sf::Uint16 lhs, sf::Uint16 rhs)
+	{
+		return ((lhs > rhs) && (lhs - rhs <= 32768)) || ((lhs < rhs) && (rhs - lhs > 32768));
+	}
+}
+
+UdpConnection::SentDatagram::SentDatagram()
+	: m_sequence(0)
+	, m_time(sf::Time::Zero)
+	, m_reliable_sequences()
+	, m_valid(false)
+{
+}
+
+UdpConnection::UdpConnection(UdpHost& host, const sf::IpAddress& address, unsigned short port, State state)
+	: m_host(host)
+	, m_address(address)
+	, m_port(port)
+	, m_state(state)
+	, m_local_sequence(0)
+	, m_next_reliable_sequence(0)
+	, m_next_unreliable_sequence(0)
+	, m_last_send_time(host.Now())
+	, m_round_trip_time(sf::milliseconds(100))
+	, m_loss_check_sequence(0)
+	, m_received_any(false)
+	, m_remote_sequence(0)
+	, m_ack_bits(0)
+	, m_next_reliable_expected(0)
+	, m_received_unreliable(false)
+	, m_last_unreliable_received(0)
+	, m_last_receive_time(host.Now())
+{
+}
+
+void UdpConnection::Send(const MessagePayload& payload, Delivery delivery)
+{
+	if (m_state == State::kDisconnected || payload->size() > kMaxMessageSize)
+	{
+		return;
+	}
+
+	//Unreliable messages only live until the next flush, so they are copied rather than shared
+	if (delivery == Delivery::kUnreliableSequenced)
+	{
+		Send(payload->data(), payload->size(), delivery);
+		return;
+	}
+
+	if (m_pending_reliable.size() >= kMaxPendingReliable)
+	{
+		Drop();
+		return;
+	}
+
+	//Reliable messages wait in the pending queue until connected
+	OutgoingMessage message;
+	message.m_delivery = delivery;
+	message.m_sequence = m_next_reliable_sequence++;
+	message.m_payload = payload;
+	message.m_offset = 0;
+	message.m_size = payload->size();
+	message.m_last_sent = sf::Time::Zero;
+	message.m_sent = false;
+	m_pending_reliable.emplace_back(message);
+}
+
+void UdpConnection::Send(const char* data, std::size_t size, Delivery delivery)
+{
+	//Too large to ever be sent, rejected before it is copied
+	if (m_state == State::kDisconnected || size > kMaxMessageSize)
+	{
+		return;
+	}
+
+	if (delivery == Delivery::kReliableOrdered)
+	{
+		Send(MakePayload(data, size), delivery);
+		return;
+	}
+
+	//Unreliable messages sent before the connection is up are simply dropped
+	if (m_state != State::kConnected)
+	{
+		return;
+	}
+
+	OutgoingMessage message;
+	message.m_delivery = delivery;
+	message.m_sequence = m_next_unreliable_sequence++;
+	message.m_offset = m_unreliable_data.size();
+	message.m_size = size;
+	message.m_last_sent = sf::Time::Zero;
+	message.m_sent = false;
+	m_unreliable_data.insert(m_unreliable_data.end(), data, data + size);
+	m_queued_unreliable.emplace_back(message);
+}
+
+void UdpConnection::Flush()
+{
+	if (m_state != State::kConnected)
+	{
+		return;
+	}
+
+	//Send reliable messages that have never been sent or have gone unacknowledged for too long, followed by
+	//everything unreliable queued since the last flush, packing as many as fit into each datagram
+	sf::Time now = m_host.Now();
+	sf::Time resend_timeout = GetResendTimeout();
+
+	std::vector<const OutgoingMessage*>& batch = m_batch;
+	batch.clear();
+	std::size_t batch_size = kDataHeaderSize;
+	auto add_to_batch = [&](const OutgoingMessage& message)
+	{
+		std::size_t message_size = kMessageHeaderSize + message.m_size;
+		if (!batch.empty() && (batch_size + message_size > UdpHost::kMaxDatagramPayload || batch.size() == 255))
+		{
+			SendDatagram(batch);
+			batch.clear();
+			batch_size = kDataHeaderSize;
+		}
+		batch.emplace_back(&message);
+		batch_size += message_size;
+	};
+
+	for (OutgoingMessage& message : m_pending_reliable)
+	{
+		if (message.m_sent && now - message.m_last_sent < resend_timeout)
+		{
+			continue;
+		}
+
+		message.m_sent = true;
+		message.m_last_sent = now;
+		add_to_batch(message);
+	}
+
+	for (const OutgoingMessage& message : m_queued_unreliable)
+	{
+		add_to_batch(message);
+	}
+
+	//Keep the connection alive and our acks flowing even when there is nothing to send
+	if (!batch.empty() || now - m_last_send_time >= kKeepAliveInterval)
+	{
+		SendDatagram(batch);
+	}
+	batch.clear();
+	m_queued_unreliable.clear();
+	m_unreliable_data.clear();
+}
+
+bool UdpConnection::Receive(sf::Packet& packet)
+{
+	if (m_received.empty())
+	{
+		return false;
+	}
+
+	packet.clear();
+	std::vector<char>& data = m_received.front();
+	if (!data.empty())
+	{
+		packet.append(data.data(), data.size());
+	}
+	m_free_buffers.emplace_back(std::move(data));
+	m_received.pop();
+	return true;
+}
+
+bool UdpConnection::IsConnected() const
+{
+	return m_state == State::kConnected;
+}
+
+UdpConnection::State UdpConnection::GetState() const
+{
+	return m_state;
+}
+
+void UdpConnection::SetState(State state)
+{
+	m_state = state;
+}
+
+const sf::IpAddress& UdpConnection::GetAddress() const
+{
+	return m_address;
+}
+
+unsigned short UdpConnection::GetPort() const
+{
+	return m_port;
+}
+
+sf::Time UdpConnection::GetRoundTripTime() const
+{
+	return m_round_trip_time;
+}
+
+sf::Time UdpConnection::GetLastReceiveTime() const
+{
+	return m_last_receive_time;
+}
+
+sf::Time UdpConnection::GetTimeSinceLastReceive() const
+{
+	return m_host.Now() - m_last_receive_time;
+}
+
+const ConnectionTraffic& UdpConnection::GetTraffic() const
+{
+	return m_traffic;
+}
+
+void UdpConnection::HandleDataDatagram(const char* data, std::size_t size)
+{
+	const char* cursor = data;
+	const char* end = data + size;
+
+	sf::Uint16 sequence, ack;
+	sf::Uint32 ack_bits;
+	sf::Uint8 flags, message_count;
+	if (!ReadUint16(cursor, end, sequence) || !ReadUint16(cursor, end, ack) || !ReadUint32(cursor, end, ack_bits) || !ReadUint8(cursor, end, flags) || !ReadUint8(cursor, end, message_count))
+	{
+		return;
+	}
+
+	//Data from the server also means our connect request was accepted, even if the accept datagram was lost
+	if (m_state == State::kConnecting)
+	{
+		m_state = State::kConnected;
+	}
+
+	m_last_receive_time = m_host.Now();
+	m_traffic.m_bytes_received += size;
+	UpdateReceivedSequence(sequence);
+	if (flags & kAckValid)
+	{
+		HandleAcks(ack, ack_bits);
+	}
+
+	for (sf::Uint8 i = 0; i < message_count; ++i)
+	{
+		sf::Uint8 delivery;
+		sf::Uint16 message_sequence, message_size;
+		if (!ReadUint8(cursor, end, delivery) || !ReadUint16(cursor, end, message_sequence) || !ReadUint16(cursor, end, message_size) || end - cursor < message_size)
+		{
+			return;
+		}
+
+		std::vector<char> payload = AcquireReceiveBuffer(cursor, message_size);
+		cursor += message_size;
+
+		if (static_cast<Delivery>(delivery) == Delivery::kReliableOrdered)
+		{
+			if (message_sequence == m_next_reliable_expected)
+			{
+				m_received.push(std::move(payload));
+				++m_next_reliable_expected;
+
+				//Deliver anything that was waiting on this message
+				auto itr = m_reliable_out_of_order.find(m_next_reliable_expected);
+				while (itr != m_reliable_out_of_order.end())
+				{
+					m_received.push(std::move(itr->second));
+					m_reliable_out_of_order.erase(itr);
+					itr = m_reliable_out_of_order.find(++m_next_reliable_expected);
+				}
+			}
+			else if (SequenceGreaterThan(message_sequence, m_next_reliable_expected))
+			{
+				if (static_cast<sf::Uint16>(message_sequence - m_next_reliable_expected) >= kMaxPendingReliable)
+				{
+					Drop();
+					return;
+				}
+				m_reliable_out_of_order.emplace(message_sequence, std::move(payload));
+			}
+			//Otherwise it is a resend of something already delivered
+		}
+		else
+		{
+			if (!m_received_unreliable || SequenceGreaterThan(message_sequence, m_last_unreliable_received))
+			{
+				m_received_unreliable = true;
+				m_last_unreliable_received = message_sequence;
+				m_received.push(std::move(payload));
+			}
+		}
+	}
+}
+
+void UdpConnection::Update()
+{
+	CountLostDatagrams();
+	Flush();
+}
+
+void UdpConnection::Drop()
+{
+	//Tell the other end rather than leave it to time out, then free everything queued either way
+	m_host.SendControl(UdpHost::DatagramType::kDisconnect, m_address, m_port);
+	m_state = State::kDisconnected;
+	m_pending_reliable.clear();
+	m_queued_unreliable.clear();
+	m_unreliable_data.clear();
+	m_reliable_out_of_order.clear();
+}
+
+void UdpConnection::SendDatagram(const std::vector<const OutgoingMessage*>& messages)
+{
+	sf::Uint16 sequence = m_local_sequence++;
+
+	std::vector<char>& datagram = m_datagram;
+	datagram.clear();
+	UdpHost::WriteHeader(datagram, UdpHost::DatagramType::kData);
+	WriteUint16(datagram, sequence);
+	WriteUint16(datagram, m_remote_sequence);
+	WriteUint32(datagram, m_ack_bits);
+	WriteUint8(datagram, m_received_any ? kAckValid : 0);
+	WriteUint8(datagram, static_cast<sf::Uint8>(messages.size()));
+
+	SentDatagram& sent = m_sent_datagrams[sequence % m_sent_datagrams.size()];
+	sent.m_sequence = sequence;
+	sent.m_time = m_host.Now();
+	sent.m_reliable_sequences.clear();
+	sent.m_valid = true;
+
+	for (const OutgoingMessage* message : messages)
+	{
+		WriteUint8(datagram, static_cast<sf::Uint8>(message->m_delivery));
+		WriteUint16(datagram, message->m_sequence);
+		WriteUint16(datagram, static_cast<sf::Uint16>(message->m_size));
+		const char* data = GetMessageData(*message);
+		datagram.insert(datagram.end(), data, data + message->m_size);
+
+		if (message->m_delivery == Delivery::kReliableOrdered)
+		{
+			sent.m_reliable_sequences.emplace_back(message->m_sequence);
+		}
+	}
+
+	m_host.SendDatagram(datagram, m_address, m_port);
+	m_last_send_time = m_host.Now();
+	m_traffic.m_datagrams_sent++;
+	m_traffic.m_bytes_sent += datagram.size();
+}
+
+const char* UdpConnection::GetMessageData(const OutgoingMessage& message) const
+{
+	if (message.m_payload)
+	{
+		return message.m_payload->data();
+	}
+	return m_unreliable_data.data() + message.m_offset;
+}
+
+std::vector<char> UdpConnection::AcquireReceiveBuffer(const char* data, std::size_t size)
+{
+	std::vector<char> buffer;
+	if (!m_free_buffers.empty())
+	{
+		buffer = std::move(m_free_buffers.back());
+		m_free_buffers.pop_back();
+	}
+	buffer.assign(data, data + size);
+	return buffer;
+}
+
+void UdpConnection::HandleAcks(sf::Uint16 ack, sf::Uint32 ack_bits)
+{
+	//Bit n of ack_bits acknowledges datagram ack - n - 1
+	for (sf::Uint32 i = 0; i <= 32; ++i)
+	{
+		if (i > 0 && !(ack_bits & (1u << (i - 1))))
+		{
+			continue;
+		}
+
+		sf::Uint16 sequence = static_cast<sf::Uint16>(ack - i);
+		SentDatagram& sent = m_sent_datagrams[sequence % m_sent_datagrams.size()];
+		if (!sent.m_valid || sent.m_sequence != sequence)
+		{
+			continue;
+		}
+		sent.m_valid = false;
+		m_traffic.m_datagrams_acked++;
+
+		//Smooth the round trip time so one late ack does not swing the resend timeout
+		sf::Time sample = m_host.Now() - sent.m_time;
+		m_round_trip_time = m_round_trip_time * 0.9f + sample * 0.1f;
+
+		for (sf::Uint16 reliable_sequence : sent.m_reliable_sequences)
+		{
+			auto itr = std::find_if(m_pending_reliable.begin(), m_pending_reliable.end(), [reliable_sequence](const OutgoingMessage& message)
+			{
+				return message.m_sequence == reliable_sequence;
+			});
+			if (itr != m_pending_reliable.end())
+			{
+				m_pending_reliable.erase(itr);
+			}
+		}
+	}
+}
+
+void UdpConnection::UpdateReceivedSequence(sf::Uint16 sequence)
+{
+	if (!m_received_any)
+	{
+		m_received_any = true;
+		m_remote_sequence = sequence;
+		m_ack_bits = 0;
+	}
+	else if (SequenceGreaterThan(sequence, m_remote_sequence))
+	{
+		sf::Uint16 shift = static_cast<sf::Uint16>(sequence - m_remote_sequence);
+		m_ack_bits = (shift >= 32) ? 0 : (m_ack_bits << shift);
+		if (shift <= 32)
+		{
+			m_ack_bits |= 1u << (shift - 1);
+		}
+		m_remote_sequence = sequence;
+	}
+	else
+	{
+		sf::Uint16 behind = static_cast<sf::Uint16>(m_remote_sequence - sequence);
+		if (behind >= 1 && behind <= 32)
+		{
+			m_ack_bits |= 1u << (behind - 1);
+		}
+	}
+}
+
+void UdpConnection::CountLostDatagrams()
+{
+	//Datagrams go out in sequence order, so stop at the first one that may still be acknowledged.
+	//One whose slot has been reused was acknowledged or counted long ago
+	sf::Time now = m_host.Now();
+	while (m_loss_check_sequence != m_local_sequence)
+	{
+		SentDatagram& sent = m_sent_datagrams[m_loss_check_sequence % m_sent_datagrams.size()];
+		if (sent.m_valid && sent.m_sequence == m_loss_check_sequence)
+		{
+			if (now - sent.m_time < kLossTimeout)
+			{
+				break;
+			}
+			sent.m_valid = false;
+			m_traffic.m_datagrams_lost++;
+		}
+		++m_loss_check_sequence;
+	}
+}
+
+sf::Time UdpConnection::GetResendTimeout() const
+{
+	return std::max(kMinimumResendTimeout, m_round_trip_time * 2.f);
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <array>
+#include <deque>
+#include <map>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "Connection.hpp"
+
+class UdpHost;
+
+//One end of a connection multiplexed over the UdpHost's socket. Every datagram carries a sequence number
+//and acknowledges the last 33 datagrams received, which is what the reliable channel uses to know what to resend
+class UdpConnection : public Connection, private sf::NonCopyable
+{
+public:
+	enum class State
+	{
+		kConnecting,
+		kConnected,
+		kDisconnected
+	};
+
+public:
+	UdpConnection(UdpHost& host, const sf::IpAddress& address, unsigned short port, State state);
+
+	using Connection::Send;
+	void Send(const MessagePayload& payload, Delivery delivery) override;
+	void Send(const char* data, std::size_t size, Delivery delivery) override;
+	void Flush() override;
+	bool Receive(sf::Packet& packet) override;
+	bool IsConnected() const override;
+	sf::Time GetTimeSinceLastReceive() const override;
+	const ConnectionTraffic& GetTraffic() const override;
+
+	State GetState() const;
+	void SetState(State state);
+	const sf::IpAddress& GetAddress() const;
+	unsigned short GetPort() const;
+	sf::Time GetRoundTripTime() const;
+	sf::Time GetLastReceiveTime() const;
+
+	//Called by UdpHost
+	void HandleDataDatagram(const char* data, std::size_t size);
+	void Update();
+
+private:
+	//Reliable messages keep their payload until acknowledged, unreliable ones live in m_unreliable_data at
+	//m_offset until the next Flush
+	struct OutgoingMessage
+	{
+		Delivery m_delivery;
+		sf::Uint16 m_sequence;
+		MessagePayload m_payload;
+		std::size_t m_offset;
+		std::size_t m_size;
+		sf::Time m_last_sent;
+		bool m_sent;
+	};
+
+	struct SentDatagram
+	{
+		SentDatagram();
+		sf::Uint16 m_sequence;
+		sf::Time m_time;
+		std::vector<sf::Uint16> m_reliable_sequences;
+		bool m_valid;
+	};
+
+private:
+	//Gives up on a peer whose reliable queues hit their limit
+	void Drop();
+	void SendDatagram(const std::vector<const OutgoingMessage*>& messages);
+	const char* GetMessageData(const OutgoingMessage& message) const;
+	std::vector<char> AcquireReceiveBuffer(const char* data, std::size_t size);
+	void HandleAcks(sf::Uint16 ack, sf::Uint32 ack_bits);
+	void UpdateReceivedSequence(sf::Uint16 sequence);
+	void CountLostDatagrams();
+	sf::Time GetResendTimeout() const;
+
+private:
+	UdpHost& m_host;
+	sf::IpAddress m_address;
+	unsigned short m_port;
+	State m_state;
+
+	//Sending side
+	sf::Uint16 m_local_sequence;
+	sf::Uint16 m_next_reliable_sequence;
+	sf::Uint16 m_next_unreliable_sequence;
+	std::deque<OutgoingMessage> m_pending_reliable;
+	std::vector<OutgoingMessage> m_queued_unreliable;
+	std::vector<char> m_unreliable_data;
+	//Reused by every Flush so a steady stream of sends allocates nothing
+	std::vector<const OutgoingMessage*> m_batch;
+	std::vector<char> m_datagram;
+	std::array<SentDatagram, 256> m_sent_datagrams;
+	sf::Time m_last_send_time;
+	sf::Time m_round_trip_time;
+	ConnectionTraffic m_traffic;
+	//Oldest sent datagram not yet known to be acknowledged or lost
+	sf::Uint16 m_loss_check_sequence;
+
+	//Receiving side
+	bool m_received_any;
+	sf::Uint16 m_remote_sequence;
+	sf::Uint32 m_ack_bits;
+	sf::Uint16 m_next_reliable_expected;
+	std::map<sf::Uint16, std::vector<char>> m_reliable_out_of_order;
+	bool m_received_unreliable;
+	sf::Uint16 m_last_unreliable_received;
+	std::queue<std::vector<char>> m_received;
+	//Buffers handed back by Receive, reused for the next messages that arrive
+	std::vector<std::vector<char>> m_free_buffers;
+	sf::Time m_last_receive_time;
+};
@@ -0,0 +1,258 @@
+#include "UdpHost.hpp"
+
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+	const sf::Time kConnectRetryInterval = sf::milliseconds(100);
+	const sf::Time kMaxConnectRetryInterval = sf::seconds(1.f);
+	const std::size_t kHeaderSize = 5;
+}
+
+UdpHost::TrafficCounters::TrafficCounters()
+	: m_datagrams_sent(0)
+	, m_bytes_sent(0)
+	, m_datagrams_received(0)
+	, m_bytes_received(0)
+{
+}
+
+UdpHost::UdpHost()
+	: m_accepting(false)
+	, m_simulated_loss(0.f)
+	, m_random_engine(static_cast<unsigned long>(std::time(nullptr)))
+	, m_receive_buffer(sf::UdpSocket::MaxDatagramSize)
+	, m_last_connect_attempt(sf::Time::Zero)
+	, m_connect_retry_interval(kConnectRetryInterval)
+{
+	m_socket.setBlocking(false);
+}
+
+UdpHost::~UdpHost()
+{
+	//Best effort goodbye, the other side times out if this gets lost
+	for (auto& pair : m_connections)
+	{
+		if (pair.second->GetState() != UdpConnection::State::kDisconnected)
+		{
+			SendControl(DatagramType::kDisconnect, pair.second->GetAddress(), pair.second->GetPort());
+		}
+	}
+}
+
+bool UdpHost::Listen(unsigned short port)
+{
+	return m_socket.bind(port) == sf::Socket::Done;
+}
+
+void UdpHost::SetAcceptingConnections(bool accept)
+{
+	m_accepting = accept;
+}
+
+UdpConnection* UdpHost::Accept()
+{
+	if (m_accepted.empty())
+	{
+		return nullptr;
+	}
+
+	UdpConnection* connection = m_accepted.front();
+	m_accepted.pop();
+	return connection;
+}
+
+UdpConnection* UdpHost::Connect(const sf::IpAddress& address, unsigned short port)
+{
+	if (m_socket.getLocalPort() == 0 && m_socket.bind(sf::Socket::AnyPort) != sf::Socket::Done)
+	{
+		return nullptr;
+	}
+
+	Endpoint endpoint(address.toInteger(), port);
+	ConnectionPtr& connection = m_connections[endpoint];
+	connection.reset(new UdpConnection(*this, address, port, UdpConnection::State::kConnecting));
+
+	SendControl(DatagramType::kConnect, address, port);
+	m_last_connect_attempt = Now();
+	m_connect_retry_interval = kConnectRetryInterval;
+	return connection.get();
+}
+
+void UdpHost::Disconnect(const Connection* connection)
+{
+	for (auto itr = m_connections.begin(); itr != m_connections.end(); ++itr)
+	{
+		if (itr->second.get() == connection)
+		{
+			if (itr->second->GetState() != UdpConnection::State::kDisconnected)
+			{
+				SendControl(DatagramType::kDisconnect, itr->second->GetAddress(), itr->second->GetPort());
+			}
+			m_connections.erase(itr);
+			return;
+		}
+	}
+}
+
+void UdpHost::Receive()
+{
+	std::size_t received;
+	sf::IpAddress address;
+	unsigned short port;
+	while (m_socket.receive(m_receive_buffer.data(), m_receive_buffer.size(), received, address, port) == sf::Socket::Done)
+	{
+		++m_traffic.m_datagrams_received;
+		m_traffic.m_bytes_received += received;
+		HandleDatagram(m_receive_buffer.data(), received, address, port);
+	}
+}
+
+void UdpHost::Update()
+{
+	bool retry_connect = Now() - m_last_connect_attempt >= m_connect_retry_interval;
+	bool retried = false;
+	for (auto& pair : m_connections)
+	{
+		UdpConnection& connection = *pair.second;
+		if (connection.GetState() == UdpConnection::State::kConnecting && retry_connect)
+		{
+			SendControl(DatagramType::kConnect, connection.GetAddress(), connection.GetPort());
+			retried = true;
+		}
+		connection.Update();
+	}
+
+	if (retried)
+	{
+		m_last_connect_attempt = Now();
+		m_connect_retry_interval = std::min(m_connect_retry_interval * 2.f, kMaxConnectRetryInterval);
+	}
+}
+
+sf::UdpSocket& UdpHost::GetSocket()
+{
+	return m_socket;
+}
+
+sf::Time UdpHost::Now() const
+{
+	return m_clock.getElapsedTime();
+}
+
+const UdpHost::TrafficCounters& UdpHost::GetTraffic() const
+{
+	return m_traffic;
+}
+
+void UdpHost::SetSimulatedLoss(float loss)
+{
+	m_simulated_loss = loss;
+}
+
+void UdpHost::SendDatagram(const std::vector<char>& datagram, const sf::IpAddress& address, unsigned short port)
+{
+	if (m_simulated_loss > 0.f)
+	{
+		std::uniform_real_distribution<float> distr(0.f, 1.f);
+		if (distr(m_random_engine) < m_simulated_loss)
+		{
+			return;
+		}
+	}
+
+	if (m_socket.send(datagram.data(), datagram.size(), address, port) == sf::Socket::Done)
+	{
+		++m_traffic.m_datagrams_sent;
+		m_traffic.m_bytes_sent += datagram.size();
+	}
+}
+
+void UdpHost::SendControl(DatagramType type, const sf::IpAddress& address, unsigned short port)
+{
+	std::vector<char> datagram;
+	WriteHeader(datagram, type);
+	SendDatagram(datagram, address, port);
+}
+
+void UdpHost::WriteHeader(std::vector<char>& datagram, DatagramType type)
+{
+	datagram.push_back(static_cast<char>((kProtocolId >> 24) & 0xFF));
+	datagram.push_back(static_cast<char>((kProtocolId >> 16) & 0xFF));
+	datagram.push_back(static_cast<char>((kProtocolId >> 8) & 0xFF));
+	datagram.push_back(static_cast<char>(kProtocolId & 0xFF));
+	datagram.push_back(static_cast<char>(type));
+}
+
+void UdpHost::HandleDatagram(const char* data, std::size_t size, const sf::IpAddress& address, unsigned short port)
+{
+	//Ignore anything that is not ours
+	if (size < kHeaderSize)
+	{
+		return;
+	}
+
+	sf::Uint32 protocol_id = 0;
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		protocol_id = (protocol_id << 8) | static_cast<sf::Uint8>(data[i]);
+	}
+	if (protocol_id != kProtocolId)
+	{
+		return;
+	}
+
+	DatagramType type = static_cast<DatagramType>(data[4]);
+	Endpoint endpoint(address.toInteger(), port);
+	auto itr = m_connections.find(endpoint);
+
+	switch (type)
+	{
+	case DatagramType::kConnect:
+	{
+		if (itr == m_connections.end())
+		{
+			if (!m_accepting)
+			{
+				return;
+			}
+
+			ConnectionPtr connection(new UdpConnection(*this, address, port, UdpConnection::State::kConnected));
+			m_accepted.push(connection.get());
+			m_connections[endpoint] = std::move(connection);
+		}
+
+		//Also answers repeated connect requests whose accept got lost
+		SendControl(DatagramType::kAccept, address, port);
+	}
+	break;
+
+	case DatagramType::kAccept:
+	{
+		if (itr != m_connections.end() && itr->second->GetState() == UdpConnection::State::kConnecting)
+		{
+			itr->second->SetState(UdpConnection::State::kConnected);
+		}
+	}
+	break;
+
+	case DatagramType::kData:
+	{
+		if (itr != m_connections.end() && itr->second->GetState() != UdpConnection::State::kDisconnected)
+		{
+			itr->second->HandleDataDatagram(data + kHeaderSize, size - kHeaderSize);
+		}
+	}
+	break;
+
+	case DatagramType::kDisconnect:
+	{
+		if (itr != m_connections.end())
+		{
+			itr->second->SetState(UdpConnection::State::kDisconnected);
+		}
+	}
+	break;
+	}
+}
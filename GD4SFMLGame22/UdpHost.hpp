@@ -0,0 +1,93 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/UdpSocket.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include "UdpConnection.hpp"
+
+//Owns the UDP socket and the connections multiplexed over it. The server listens on a port and accepts
+//connections, a client connects to exactly one server. Neither side blocks: call Receive to drain the socket
+//and Update to handle resends, keep alives and connection attempts
+class UdpHost : private sf::NonCopyable
+{
+public:
+	//Datagram kinds, the first byte after the protocol id
+	enum class DatagramType
+	{
+		kConnect,
+		kAccept,
+		kData,
+		kDisconnect
+	};
+
+	//Everything that went through the socket since the host was created
+	struct TrafficCounters
+	{
+		TrafficCounters();
+		std::size_t m_datagrams_sent;
+		std::size_t m_bytes_sent;
+		std::size_t m_datagrams_received;
+		std::size_t m_bytes_received;
+	};
+
+	static const sf::Uint32 kProtocolId = 0x4D524E31;
+	//Messages are packed into datagrams up to this size, comfortably below a typical MTU
+	static const std::size_t kMaxDatagramPayload = 1200;
+
+public:
+	UdpHost();
+	~UdpHost();
+
+	bool Listen(unsigned short port);
+	void SetAcceptingConnections(bool accept);
+	UdpConnection* Accept();
+
+	UdpConnection* Connect(const sf::IpAddress& address, unsigned short port);
+	//Does nothing for a connection this host does not own
+	void Disconnect(const Connection* connection);
+
+	void Receive();
+	void Update();
+
+	sf::UdpSocket& GetSocket();
+	sf::Time Now() const;
+	const TrafficCounters& GetTraffic() const;
+
+	//Randomly drops this fraction of outgoing datagrams, for testing on loopback
+	void SetSimulatedLoss(float loss);
+
+	//Used by UdpConnection
+	void SendDatagram(const std::vector<char>& datagram, const sf::IpAddress& address, unsigned short port);
+	void SendControl(DatagramType type, const sf::IpAddress& address, unsigned short port);
+	static void WriteHeader(std::vector<char>& datagram, DatagramType type);
+
+private:
+	typedef std::pair<sf::Uint32, unsigned short> Endpoint;
+	typedef std::unique_ptr<UdpConnection> ConnectionPtr;
+
+private:
+	void HandleDatagram(const char* data, std::size_t size, const sf::IpAddress& address, unsigned short port);
+
+private:
+	sf::UdpSocket m_socket;
+	sf::Clock m_clock;
+	bool m_accepting;
+	float m_simulated_loss;
+	std::default_random_engine m_random_engine;
+
+	std::map<Endpoint, ConnectionPtr> m_connections;
+	std::queue<UdpConnection*> m_accepted;
+	std::vector<char> m_receive_buffer;
+	sf::Time m_last_connect_attempt;
+	//Doubles with every unanswered connection request, so a server that is down is not flooded
+	sf::Time m_connect_retry_interval;
+	TrafficCounters m_traffic;
+};
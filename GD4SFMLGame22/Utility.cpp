@@ -7,18 +7,19 @@
 
 
 #include <cmath>
-#include <random>
+#include <functional>
+#include <thread>
 #include "Animation.hpp"
+#include "RandomStream.hpp"
 
 namespace
 {
-	std::default_random_engine CreateRandomEngine()
+	//Each thread draws from its own stream, so the game and an embedded server never contend on one engine
+	RandomStream& ThreadRandomStream()
 	{
-		auto seed = static_cast<unsigned long>(std::time(nullptr));
-		return std::default_random_engine(seed);
+		thread_local RandomStream stream(RandomStream::SeedFromClock(), std::hash<std::thread::id>()(std::this_thread::get_id()));
+		return stream;
 	}
-
-	auto RandomEngine = CreateRandomEngine();
 }
 
 
@@ -178,6 +179,5 @@ float Utility::ToDegrees(float angle_in_radians)
 
 int Utility::RandomInt(int exclusiveMax)
 {
-	std::uniform_int_distribution<> distr(0, exclusiveMax - 1);
-	return distr(RandomEngine);
+	return ThreadRandomStream().NextInt(exclusiveMax);
 }
@@ -0,0 +1,53 @@
+#include "WakeSignal.hpp"
+
+#include <SFML/Network/IpAddress.hpp>
+
+WakeSignal::WakeSignal()
+	: m_port(0)
+	, m_pending(false)
+{
+	//Neither side may ever block, the notifier is usually a game loop
+	m_receiver.setBlocking(false);
+	m_sender.setBlocking(false);
+}
+
+bool WakeSignal::Bind()
+{
+	if (m_receiver.bind(sf::Socket::AnyPort, sf::IpAddress::LocalHost) != sf::Socket::Done)
+	{
+		return false;
+	}
+	m_port = m_receiver.getLocalPort();
+	return true;
+}
+
+sf::UdpSocket& WakeSignal::GetSocket()
+{
+	return m_receiver;
+}
+
+void WakeSignal::Notify()
+{
+	if (m_port == 0 || m_pending.exchange(true))
+	{
+		return;
+	}
+
+	const char wake = 0;
+	m_sender.send(&wake, sizeof(wake), sf::IpAddress::LocalHost, m_port);
+}
+
+void WakeSignal::Clear()
+{
+	char buffer[16];
+	std::size_t received = 0;
+	sf::IpAddress sender;
+	unsigned short port = 0;
+	while (m_receiver.receive(buffer, sizeof(buffer), received, sender, port) == sf::Socket::Done)
+	{
+	}
+
+	//Drained first, so a notify from here on sends a datagram that is still there for the next wait. One that came
+	//in between saw m_pending still set, and what it signalled was done before this exchange
+	m_pending.exchange(false);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <atomic>
+
+#include <SFML/Network/UdpSocket.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+//Wakes a thread blocked in a SocketSelector from another thread, with a one byte datagram to itself on the loopback
+//interface. Notifies are coalesced, at most one datagram is in flight until the waiting thread calls Clear
+class WakeSignal : private sf::NonCopyable
+{
+public:
+	WakeSignal();
+
+	//Binds the socket to add to the selector, false if no loopback port could be had
+	bool Bind();
+	sf::UdpSocket& GetSocket();
+
+	//Any thread
+	void Notify();
+	//The waiting thread, after the selector returns and before it looks for what it was woken for
+	void Clear();
+
+private:
+	sf::UdpSocket m_receiver;
+	sf::UdpSocket m_sender;
+	unsigned short m_port;
+	std::atomic<bool> m_pending;
+};
@@ -1,14 +1,14 @@
 #include "World.hpp"
 
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <functional>
 #include <iostream>
 #include <limits>
 
-#include "Obstacle.hpp"
 #include "ParticleNode.hpp"
 #include "ParticleType.hpp"
-#include "Pickup.hpp"
 #include "PostEffect.hpp"
+#include "RandomStream.hpp"
 #include "SoundNode.hpp"
 #include "Utility.hpp"
 
@@ -30,6 +30,7 @@ World::World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sou
 	, m_obstacle_spawn_points()
 	, m_pickup_spawn_points()
 	, m_active_enemies()
+	, m_entities(nullptr)
 	, m_networked_world(networked)
 	, m_network_node(nullptr)
 	, m_host_dead(false)
@@ -38,6 +39,7 @@ World::World(sf::RenderTarget& output_target, FontHolder& font, SoundPlayer& sou
 	m_scene_texture.create(m_target.getSize().x, m_target.getSize().y);
 
 	LoadTextures();
+	m_scenegraph.IndexCategories();
 	BuildScene();
 	m_camera.setCenter(m_spawn_position);
 }
@@ -55,9 +57,13 @@ void World::Update(sf::Time dt)
 	//Scroll the world
 	m_camera.move(-(m_scrollspeed * dt.asSeconds() * m_scrollspeed_compensation), 0);
 
+	//Network driven bikes keep the velocity prediction or interpolation gave them
 	for (Bike* a : m_player_bike)
 	{
-		a->SetVelocity(0.f, 0.f);
+		if (!a->IsNetworkDriven())
+		{
+			a->SetVelocity(0.f, 0.f);
+		}
 	}
 
 	DestroyEntitiesOutsideView();
@@ -76,7 +82,9 @@ void World::Update(sf::Time dt)
 	auto first_to_remove = std::remove_if(m_player_bike.begin(), m_player_bike.end(), std::mem_fn(&Bike::IsMarkedForRemoval));
 	m_player_bike.erase(first_to_remove, m_player_bike.end());
 	m_scenegraph.RemoveWrecks();
+	m_entities->RemoveDestroyed();
 
+	GenerateTrack();
 	SpawnObstacles();
 	SpawnPickups();
 
@@ -116,12 +124,15 @@ Bike* World::GetBike(int identifier) const
 	return nullptr;
 }
 
-void World::RemoveBike(int identifier)
+void World::RemoveBike(int identifier, bool explode)
 {
 	Bike* aircraft = GetBike(identifier);
 	if (aircraft)
 	{
-		aircraft->Destroy();
+		if (explode)
+			aircraft->Destroy();
+		else
+			aircraft->Remove();
 		m_player_bike.erase(std::find(m_player_bike.begin(), m_player_bike.end(), aircraft));
 	}
 }
@@ -141,10 +152,7 @@ Bike* World::AddBike(int identifier)
 
 void World::CreatePickup(sf::Vector2f position, PickupType type)
 {
-	std::unique_ptr<Pickup> pickup(new Pickup(type, m_textures));
-	pickup->setPosition(position);
-	pickup->SetVelocity(0.f, 1.f);
-	m_scene_layers[static_cast<int>(Layers::kUpperAir)]->AttachChild(std::move(pickup));
+	m_entities->AddPickup(type, position, sf::Vector2f(0.f, 1.f));
 }
 
 bool World::PollGameAction(GameActions::Action& out)
@@ -158,6 +166,14 @@ void World::SetCurrentBattleFieldPosition(float lineY)
 	m_spawn_position.y = m_world_bounds.height;
 }
 
+void World::SetScrollPosition(float view_left)
+{
+	//The battlefield keeps the same distance ahead of the camera
+	float distance = view_left - GetViewBounds().left;
+	m_camera.move(distance, 0.f);
+	m_x_bound += distance;
+}
+
 void World::SetWorldHeight(float height)
 {
 	m_world_bounds.height = height;
@@ -227,6 +243,11 @@ void World::BuildScene()
 	m_finish_sprite = finish_sprite.get();
 	m_scene_layers[static_cast<int>(Layers::kBackground)]->AttachChild(std::move(finish_sprite));
 
+	//Obstacles and pickups, drawn below the bikes
+	std::unique_ptr<EntityStore> entities(new EntityStore(m_textures));
+	m_entities = entities.get();
+	m_scene_layers[static_cast<int>(Layers::kUpperAir)]->AttachChild(std::move(entities));
+
 	// Add particle node to the scene
 	std::unique_ptr<ParticleNode> smokeNode(new ParticleNode(ParticleType::kSmoke, m_textures));
 	m_scene_layers[static_cast<int>(Layers::kLowerAir)]->AttachChild(std::move(smokeNode));
@@ -246,8 +267,14 @@ void World::BuildScene()
 		m_scenegraph.AttachChild(std::move(network_node));
 	}
 
-	AddObstacles();
-	AddPickups();
+	//A networked world is sent its track's settings by the server, a single player race gets a new one every time
+	if (!m_networked_world)
+	{
+		TrackSettings track;
+		track.m_seed = RandomStream::SeedFromClock();
+		track.m_length = m_world_bounds.width;
+		SetTrack(track);
+	}
 }
 
 CommandQueue& World::GetCommandQueue()
@@ -279,7 +306,7 @@ void World::AdaptPlayerVelocity()
 	{
 		sf::Vector2f velocity = aircraft->GetVelocity();
 		//if moving diagonally then reduce velocity
-		if (velocity.x != 0.f && velocity.y != 0.f)
+		if (!aircraft->IsNetworkDriven() && velocity.x != 0.f && velocity.y != 0.f)
 		{
 			aircraft->SetVelocity(velocity / std::sqrt(2.f));
 		}
@@ -301,6 +328,42 @@ sf::FloatRect World::GetBattlefieldBounds() const
 	return bounds;
 }
 
+void World::SetTrack(const TrackSettings& settings, const TrackProgress& progress)
+{
+	m_track.reset(new TrackGenerator(settings, progress));
+}
+
+void World::GenerateTrack()
+{
+	if (!m_track)
+	{
+		return;
+	}
+
+	//Only what the battlefield has reached is generated, spawn points are used up as it moves on
+	std::vector<TrackGenerator::ObstacleSpawn> obstacles;
+	std::vector<TrackGenerator::PickupSpawn> pickups;
+	m_track->GenerateUntil(GetBattlefieldBounds().width, obstacles, pickups);
+
+	for (const TrackGenerator::ObstacleSpawn& obstacle : obstacles)
+	{
+		AddObstacle(obstacle.m_type, obstacle.m_position.x, obstacle.m_position.y);
+	}
+	for (const TrackGenerator::PickupSpawn& pickup : pickups)
+	{
+		AddPickup(pickup.m_type, pickup.m_position.x, pickup.m_position.y);
+	}
+
+	if (!obstacles.empty())
+	{
+		SortObstacles();
+	}
+	if (!pickups.empty())
+	{
+		SortPickups();
+	}
+}
+
 void World::SpawnObstacles()
 {
 
@@ -309,10 +372,7 @@ void World::SpawnObstacles()
 	{
 		//std::cout << m_x_bound << " " << m_obstacle_spawn_points.back().m_x << std::endl;
 		ObstacleSpawnPoint spawn = m_obstacle_spawn_points.back();
-		std::cout << static_cast<int>(spawn.m_type) << std::endl;
-		std::unique_ptr<Obstacle> obs(new Obstacle(spawn.m_type, m_textures));
-		obs->setPosition(spawn.m_x, spawn.m_y);
-		m_scene_layers[static_cast<int>(Layers::kUpperAir)]->AttachChild(std::move(obs));
+		m_entities->AddObstacle(spawn.m_type, sf::Vector2f(spawn.m_x, spawn.m_y));
 		m_obstacle_spawn_points.pop_back();
 	}
 }
@@ -323,78 +383,6 @@ void World::AddObstacle(ObstacleType type, float relX, float relY)
 	m_obstacle_spawn_points.emplace_back(spawn);
 }
 
-void World::AddObstacles()
-{
-	if (m_networked_world)
-	{
-		return;
-	}
-
-	//Add obstacles
-	AddObstacle(ObstacleType::kBarrier, 200.f, 650.f);
-
-	AddObstacle(ObstacleType::kTarSpill, 500.f, 750.f);
-
-	AddObstacle(ObstacleType::kTarSpill, 800.f, 950.f);
-	AddObstacle(ObstacleType::kAcidSpill, 850.f, 750.f);
-	AddObstacle(ObstacleType::kBarrier, 900.f, 650.f);
-
-	AddObstacle(ObstacleType::kBarrier, 1450.f, 950.f);
-	AddObstacle(ObstacleType::kBarrier, 1950.f, 850.f);
-	AddObstacle(ObstacleType::kBarrier, 2000.f, 650.f);
-
-	AddObstacle(ObstacleType::kAcidSpill, 2250.f, 850.f);
-	AddObstacle(ObstacleType::kTarSpill, 2250.f, 750.f);
-
-	AddObstacle(ObstacleType::kTarSpill, 2850.f, 750.f);
-	AddObstacle(ObstacleType::kAcidSpill, 3050.f, 750.f);
-	AddObstacle(ObstacleType::kTarSpill, 3550.f, 950.f);
-	AddObstacle(ObstacleType::kBarrier, 3750.f, 850.f);
-
-	AddObstacle(ObstacleType::kAcidSpill, 3750.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 4000.f, 750.f);
-
-	AddObstacle(ObstacleType::kBarrier, 4000.f, 800.f);
-	AddObstacle(ObstacleType::kAcidSpill, 4250.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 4250.f, 750.f);
-
-
-	AddObstacle(ObstacleType::kBarrier, 4500.f, 650.f);
-
-	AddObstacle(ObstacleType::kTarSpill, 4500.f, 750.f);
-
-	AddObstacle(ObstacleType::kTarSpill, 4700.f, 950.f);
-	AddObstacle(ObstacleType::kAcidSpill, 4800.f, 750.f);
-	AddObstacle(ObstacleType::kBarrier, 4800.f, 650.f);
-
-	AddObstacle(ObstacleType::kBarrier, 5300.f, 800.f);
-	AddObstacle(ObstacleType::kAcidSpill, 5450.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 5650.f, 750.f);
-
-	AddObstacle(ObstacleType::kAcidSpill, 5750.f, 750.f);
-	AddObstacle(ObstacleType::kTarSpill, 6250.f, 950.f);
-	AddObstacle(ObstacleType::kBarrier, 6550.f, 850.f);
-
-	AddObstacle(ObstacleType::kAcidSpill, 6750.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 7200.f, 750.f);
-
-	AddObstacle(ObstacleType::kBarrier, 7350.f, 800.f);
-	AddObstacle(ObstacleType::kAcidSpill, 7500.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 8000.f, 750.f);
-
-	AddObstacle(ObstacleType::kBarrier, 8200.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 8400.f, 750.f);
-
-	AddObstacle(ObstacleType::kAcidSpill, 8950.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 9300.f, 750.f);
-
-	AddObstacle(ObstacleType::kBarrier, 9500.f, 800.f);
-	AddObstacle(ObstacleType::kAcidSpill, 9750.f, 650.f);
-	AddObstacle(ObstacleType::kTarSpill, 1050.f, 750.f);
-
-	SortObstacles();
-}
-
 void World::SortObstacles()
 {
 	//Sort all enemies according to their x-value, such that lower enemies are checked first for spawning
@@ -411,10 +399,7 @@ void World::SpawnPickups()
 	{
 		//std::cout << m_x_bound << " " << m_obstacle_spawn_points.back().m_x << std::endl;
 		PickupSpawnPoint spawn = m_pickup_spawn_points.back();
-		std::cout << static_cast<int>(spawn.m_type) << std::endl;
-		std::unique_ptr<Pickup> pickup(new Pickup(spawn.m_type, m_textures));
-		pickup->setPosition(spawn.m_x, spawn.m_y);
-		m_scene_layers[static_cast<int>(Layers::kUpperAir)]->AttachChild(std::move(pickup));
+		m_entities->AddPickup(spawn.m_type, sf::Vector2f(spawn.m_x, spawn.m_y));
 		m_pickup_spawn_points.pop_back();
 	}
 }
@@ -425,31 +410,6 @@ void World::AddPickup(PickupType type, float relX, float relY)
 	m_pickup_spawn_points.emplace_back(spawn);
 }
 
-void World::AddPickups()
-{
-	if (m_networked_world)
-	{
-		return;
-	}
-
-	//Add pickups
-	AddPickup(PickupType::kBoostRefill, 500.f, 850.f);
-	AddPickup(PickupType::kBoostRefill, 1500.f, 850.f);
-	AddPickup(PickupType::kBoostRefill, 3000.f, 850.f);
-	AddPickup(PickupType::kInvincible, 3500.f, 850.f);
-
-	AddPickup(PickupType::kBoostRefill, 6500.f, 850.f);
-	AddPickup(PickupType::kBoostRefill, 4500.f, 850.f);
-	AddPickup(PickupType::kBoostRefill, 5500.f, 850.f);
-	AddPickup(PickupType::kInvincible, 7500.f, 850.f);
-
-	AddPickup(PickupType::kBoostRefill, 8000.f, 850.f);
-	AddPickup(PickupType::kBoostRefill, 8200.f, 850.f);
-	AddPickup(PickupType::kInvincible, 9200.f, 850.f);
-
-	SortPickups();
-}
-
 void World::SortPickups()
 {
 	//Sort all enemies according to their x-value, such that lower pickups are checked first for spawning
@@ -459,67 +419,62 @@ void World::SortPickups()
 		});
 }
 
-bool MatchesCategories(SceneNode::Pair& colliders, Category::Type type1, Category::Type type2)
+void World::HandleCollisions()
 {
-	unsigned int category1 = colliders.first->GetCategory();
-	unsigned int category2 = colliders.second->GetCategory();
-	if(type1 & category1 && type2 & category2)
-	{
-		return true;
-	}
-	else if(type1 & category2 && type2 & category1)
+	//Bikes against each other
+	m_colliders.clear();
+	m_scenegraph.CollectColliders(Category::kPlayerBike, m_colliders);
+	m_broad_phase.FindPairs(m_colliders, m_collision_pairs);
+	for(SceneNode::Pair pair : m_collision_pairs)
 	{
-		std::swap(colliders.first, colliders.second);
-		return true;
-	}
-	else
-	{
-		return false;
+		auto& player = static_cast<Bike&>(*pair.first);
+		auto& player2 = static_cast<Bike&>(*pair.second);
+
+		//In a networked game the server decides kills, pickups and damage and sends the results in its snapshots.
+		//Here only the visible parts happen, plus the slowdown for bikes still moved from relayed input.
+		//Predicted bikes get their slowdown from the server when they reconcile
+		if (player.GetHitPoints() == 22 || m_networked_world)
+			continue;
+		if (player.GetInvincibility())
+			player2.Destroy();
+		else if (player2.GetInvincibility())
+			player.Destroy();
 	}
-}
 
-void World::HandleCollisions()
-{
-	std::set<SceneNode::Pair> collision_pairs;
-	m_scenegraph.CheckSceneCollision(m_scenegraph, collision_pairs);
-	for(SceneNode::Pair pair : collision_pairs)
+	//Bikes against obstacles and pickups, each of the few bikes checked against the whole store
+	for(SceneNode* node : m_colliders)
 	{
-		auto& player = static_cast<Bike&>(*pair.first);
+		auto& player = static_cast<Bike&>(*node);
+		if (player.GetHitPoints() == 22)
+			continue;
 
-		if(player.GetHitPoints() != 22)
+		m_entity_overlaps.clear();
+		m_entities->FindOverlaps(player.GetBoundingRect(), Category::kPickup | Category::kObstacle, m_entity_overlaps);
+		for(std::size_t entity : m_entity_overlaps)
 		{
-			if (MatchesCategories(pair, Category::Type::kPlayerBike, Category::kPlayerBike))
-			{
-				auto& player2 = static_cast<Bike&>(*pair.second);
-
-				if (player.GetInvincibility())
-					player2.Destroy();
-				else if (player2.GetInvincibility())
-					player.Destroy();
-			}
+			//Already taken by another bike this frame
+			if (m_entities->IsEntityDestroyed(entity))
+				continue;
 
-			else if (MatchesCategories(pair, Category::Type::kPlayerBike, Category::kPickup))
+			if (m_entities->GetEntityCategory(entity) == Category::kPickup)
 			{
-				auto& pickup = static_cast<Pickup&>(*pair.second);
 				//Apply the pickup effect
-				pickup.Apply(player);
-				pickup.Destroy();
+				if (!m_networked_world)
+					m_entities->ApplyPickup(entity, player);
+				m_entities->DestroyEntity(entity);
 				player.PlayLocalSound(m_command_queue, SoundEffect::kBoostGet);
 			}
-
-			else if (MatchesCategories(pair, Category::Type::kPlayerBike, Category::Type::kObstacle))
+			else
 			{
-				auto& player = static_cast<Bike&>(*pair.first);
-				auto& obstacle = static_cast<Obstacle&>(*pair.second);
-
 				//Apply the slowdown to the plane
-				obstacle.Destroy();
+				m_entities->DestroyEntity(entity);
 				player.PlayLocalSound(m_command_queue, SoundEffect::kCollision);
 
 				if (!player.GetInvincibility())
 				{
-					player.DecreaseSpeed(obstacle.GetSlowdown());
-					player.Damage(10);
+					player.DecreaseSpeed(m_entities->GetSlowdown(entity));
+					if (!m_networked_world)
+						player.Damage(10);
 				}
 			}
 		}
@@ -528,8 +483,10 @@ void World::HandleCollisions()
 
 void World::DestroyEntitiesOutsideView()
 {
+	m_entities->DestroyOutside(GetBattlefieldBounds());
+
 	Command command;
-	command.category = Category::Type::kPlayerBike | Category::Type::kPickup | Category::Type::kObstacle;
+	command.category = Category::Type::kPlayerBike;
 	command.action = DerivedAction<Entity>([this](Entity& e, sf::Time)
 	{
 		//Does the object intersect with the battlefield
@@ -546,7 +503,7 @@ void World::DestroyEntitiesOutsideView()
 			}
 		}
 	});
-	m_command_queue.Push(command);
+	m_command_queue.Push(std::move(command));
 }
 
 void World::UpdateSounds()
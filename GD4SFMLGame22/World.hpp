@@ -6,6 +6,7 @@
 #include "Bike.hpp"
 #include "Layers.hpp"
 #include "BikeType.hpp"
+#include "EntityStore.hpp"
 #include "NetworkNode.hpp"
 
 #include <SFML/System/NonCopyable.hpp>
@@ -20,11 +21,13 @@
 #include "BloomEffect.hpp"
 #include "CommandQueue.hpp"
 #include "SoundPlayer.hpp"
+#include "SweepAndPrune.hpp"
 
 #include "NetworkProtocol.hpp"
 #include "ObstacleType.hpp"
 #include "PickupType.hpp"
 #include "PlayerAction.hpp"
+#include "TrackGenerator.hpp"
 
 namespace sf
 {
@@ -44,9 +47,13 @@ public:
 	CommandQueue& GetCommandQueue();
 
 	Bike* AddBike(int identifier);
-	void RemoveBike(int identifier);
+	void RemoveBike(int identifier, bool explode = true);
 	void SetCurrentBattleFieldPosition(float line_y);
 	void SetWorldHeight(float height);
+	//Moves the camera on to where a race already under way has scrolled to
+	void SetScrollPosition(float view_left);
+	//Obstacles and pickups are laid out from these as the battlefield reaches them
+	void SetTrack(const TrackSettings& settings, const TrackProgress& progress = TrackProgress());
 
 	void AddObstacle(ObstacleType type, float relX, float relY);
 	void SortObstacles();
@@ -73,10 +80,9 @@ private:
 	void DestroyEntitiesOutsideView();
 	void UpdateSounds();
 
+	void GenerateTrack();
 	void SpawnObstacles();
 	void SpawnPickups();
-	void AddObstacles();
-	void AddPickups();
 
 private:
 	struct SpawnPoint
@@ -133,7 +139,14 @@ private:
 	std::vector<SpawnPoint> m_enemy_spawn_points;
 	std::vector<ObstacleSpawnPoint> m_obstacle_spawn_points;
 	std::vector<PickupSpawnPoint> m_pickup_spawn_points;
+	std::unique_ptr<TrackGenerator> m_track;
 	std::vector<Bike*>	m_active_enemies;
+	EntityStore* m_entities;
+	//Bikes collide with each other and with the entity store's obstacles and pickups. Reused every frame
+	std::vector<SceneNode*> m_colliders;
+	std::vector<SceneNode::Pair> m_collision_pairs;
+	SweepAndPrune m_broad_phase;
+	std::vector<std::size_t> m_entity_overlaps;
 
 	BloomEffect m_bloom_effect;
 	bool m_networked_world;